@@ -0,0 +1,467 @@
+/**
+ * BENCH:
+ *  This file contains the benchmark suite for the Game of Life stepping
+ *  engines
+ *
+ *  Every workload is seeded deterministically, run a fixed number of
+ *  generations on each engine and board size, and timed as the best of a
+ *  few repetitions. Results are printed as JSON, one result per line, so
+ *  a previous run can be fed back in with --baseline and compared.
+ *
+ *  file: bench.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <map>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "rule.hpp"
+#include "board.hpp"
+#include "sparse.hpp"
+#include "hashlife.hpp"
+#include "threadpool.hpp"
+
+struct Workload {
+    char const *name;
+    void (*seed)(int, uint64_t, void (*)(void *, int, int), void *);
+};
+
+struct Result {
+    std::string workload;
+    std::string engine;
+    std::string rule;
+    int size;
+    uint64_t generations;
+    double seconds;
+};
+
+static void
+place_pattern(char const *const *rows, int n, int size,
+        void (*set)(void *, int, int), void *ctx)
+{
+    int origin = size / 2;
+
+    for (int y = 0; y < n; y++) {
+
+        for (int x = 0; rows[y][x]; x++) {
+
+            if (rows[y][x] == 'O')
+                set(ctx, origin + x, origin + y);
+        }
+    }
+}
+
+static void
+seed_empty(int, uint64_t, void (*)(void *, int, int), void *)
+{
+}
+
+static void
+seed_soup(int size, uint64_t seed, void (*set)(void *, int, int), void *ctx)
+{
+    std::mt19937_64 rng(seed);
+
+    for (int y = 0; y < size; y++) {
+
+        for (int x = 0; x < size; x += 64) {
+
+            uint64_t bits = rng();
+
+            for (int b = 0; b < 64 && x + b < size; b++) {
+
+                if ((bits >> b) & 1)
+                    set(ctx, x + b, y);
+            }
+        }
+    }
+}
+
+static void
+seed_r_pentomino(int size, uint64_t, void (*set)(void *, int, int), void *ctx)
+{
+    static char const *const rows[] = {".OO", "OO.", ".O."};
+    place_pattern(rows, 3, size, set, ctx);
+}
+
+static void
+seed_acorn(int size, uint64_t, void (*set)(void *, int, int), void *ctx)
+{
+    static char const *const rows[] = {".O.....", "...O...", "OO..OOO"};
+    place_pattern(rows, 3, size, set, ctx);
+}
+
+static void
+seed_gosper_gun(int size, uint64_t, void (*set)(void *, int, int), void *ctx)
+{
+    static char const *const rows[] = {
+        "........................O",
+        "......................O.O",
+        "............OO......OO............OO",
+        "...........O...O....OO............OO",
+        "OO........O.....O...OO",
+        "OO........O...O.OO....O.O",
+        "..........O.....O.......O",
+        "...........O...O",
+        "............OO",
+    };
+    place_pattern(rows, 9, size, set, ctx);
+}
+
+/* blocks on a 4-cell lattice: dense, but nothing ever changes */
+static void
+seed_still_lifes(int size, uint64_t, void (*set)(void *, int, int), void *ctx)
+{
+    for (int y = 0; y + 2 < size; y += 4) {
+
+        for (int x = 0; x + 2 < size; x += 4) {
+
+            set(ctx, x, y);
+            set(ctx, x + 1, y);
+            set(ctx, x, y + 1);
+            set(ctx, x + 1, y + 1);
+        }
+    }
+}
+
+static Workload const workloads[] = {
+    {"empty", seed_empty},
+    {"soup50", seed_soup},
+    {"r_pentomino", seed_r_pentomino},
+    {"acorn", seed_acorn},
+    {"gosper_gun", seed_gosper_gun},
+    {"still_lifes", seed_still_lifes},
+};
+
+template <typename E>
+static void
+set_alive(void *engine, int x, int y)
+{
+    static_cast<E *>(engine)->set_cell(x, y, true);
+}
+
+static void
+set_board(void *board, int x, int y)
+{
+    static_cast<Board *>(board)->set(x, y, 1);
+}
+
+/* seeds a fresh engine, then times only the stepping */
+template <typename E, typename Make>
+static double
+time_engine(Workload const& w, int size, uint64_t seed, uint64_t generations,
+        Rule const& rule, Make make, void (*set)(void *, int, int))
+{
+    std::unique_ptr<E> engine = make();
+
+    engine->set_rule(rule);
+    w.seed(size, seed, set, engine.get());
+
+    auto start = std::chrono::steady_clock::now();
+    engine->advance(generations);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return (elapsed.count());
+}
+
+static void
+print_result(FILE *out, Result const& r, bool last)
+{
+    double cells = static_cast<double>(r.size) * r.size;
+    double gps = (r.seconds > 0) ? r.generations / r.seconds : 0;
+
+    fprintf(out, "    {\"workload\": \"%s\", \"engine\": \"%s\", \"rule\": \"%s\", "
+            "\"size\": %d, \"generations\": %llu, \"seconds\": %.6f, "
+            "\"generations_per_second\": %.2f, \"cells_per_second\": %.6g}%s\n",
+            r.workload.c_str(), r.engine.c_str(), r.rule.c_str(), r.size,
+            static_cast<unsigned long long>(r.generations), r.seconds, gps,
+            gps * cells, last ? "" : ",");
+}
+
+/* pulls "key": value out of one result line of an earlier run */
+static bool
+field(std::string const& line, char const *key, std::string *value)
+{
+    std::string needle = std::string("\"") + key + "\": ";
+    size_t at = line.find(needle);
+
+    if (at == std::string::npos)
+        return (false);
+
+    at += needle.size();
+    if (line[at] == '"') {
+
+        size_t end = line.find('"', at + 1);
+        *value = line.substr(at + 1, end - at - 1);
+    } else {
+
+        size_t end = line.find_first_of(",}", at);
+        *value = line.substr(at, end - at);
+    }
+
+    return (true);
+}
+
+static std::map<std::string, double>
+read_baseline(char const *path)
+{
+    std::map<std::string, double> baseline;
+    FILE *in = fopen(path, "r");
+    char buf[1024];
+
+    if (!in) {
+
+        fprintf(stderr, "[ERROR] :: %s :: cannot open %s\n", __func__, path);
+        return (baseline);
+    }
+
+    while (fgets(buf, sizeof(buf), in)) {
+
+        std::string line(buf), workload, engine, rule, size, gps;
+
+        /* runs from before rules could be chosen were all Conway's */
+        if (!field(line, "rule", &rule))
+            rule = rule_string(R_CONWAY);
+        if (field(line, "workload", &workload) && field(line, "engine", &engine)
+                && field(line, "size", &size)
+                && field(line, "generations_per_second", &gps))
+            baseline[workload + "/" + engine + "/" + rule + "/" + size] =
+                atof(gps.c_str());
+    }
+
+    fclose(in);
+    return (baseline);
+}
+
+static std::vector<std::string>
+split(char const *list)
+{
+    std::vector<std::string> out;
+    std::string item;
+
+    for (char const *p = list; ; p++) {
+
+        if (*p == ',' || !*p) {
+
+            if (!item.empty())
+                out.push_back(item);
+            item.clear();
+            if (!*p)
+                break;
+        } else {
+
+            item += *p;
+        }
+    }
+
+    return (out);
+}
+
+static bool
+wanted(std::vector<std::string> const& filter, std::string const& name)
+{
+    return filter.empty()
+        || std::find(filter.begin(), filter.end(), name) != filter.end();
+}
+
+static void
+usage(char const *name)
+{
+    fprintf(stderr,
+            "usage: %s [--sizes 256,1024] [--engines dense-avx2,hashlife,...]\n"
+            "          [--workloads soup50,acorn,...] [--rules life,B36/S23,...]\n"
+            "          [--generations N]\n"
+            "          [--repeat N] [--threads N] [--seed N]\n"
+            "          [--baseline FILE] [--tolerance FRACTION]\n", name);
+}
+
+int
+main(int argv, char **args)
+{
+    std::vector<std::string> sizes = {"256", "512", "1024"};
+    std::vector<std::string> engines;
+    std::vector<std::string> workload_filter;
+    std::vector<std::string> rule_names = {"life"};
+    std::vector<Rule> rules;
+    char const *baseline_path = nullptr;
+    uint64_t generations = 0;
+    uint64_t seed = 42;
+    double tolerance = 0.10;
+    int repeat = 3;
+    int threads = 1;
+    int rc = EXIT_SUCCESS;
+
+    for (int i = 1; i < argv; i++) {
+
+        bool has_value = i + 1 < argv;
+
+        if (!strcmp(args[i], "--sizes") && has_value) {
+
+            sizes = split(args[++i]);
+        } else if (!strcmp(args[i], "--engines") && has_value) {
+
+            engines = split(args[++i]);
+        } else if (!strcmp(args[i], "--workloads") && has_value) {
+
+            workload_filter = split(args[++i]);
+        } else if (!strcmp(args[i], "--rules") && has_value) {
+
+            rule_names = split(args[++i]);
+        } else if (!strcmp(args[i], "--generations") && has_value) {
+
+            generations = strtoull(args[++i], nullptr, 10);
+        } else if (!strcmp(args[i], "--repeat") && has_value) {
+
+            repeat = std::max(1, atoi(args[++i]));
+        } else if (!strcmp(args[i], "--threads") && has_value) {
+
+            threads = atoi(args[++i]);
+        } else if (!strcmp(args[i], "--seed") && has_value) {
+
+            seed = strtoull(args[++i], nullptr, 10);
+        } else if (!strcmp(args[i], "--baseline") && has_value) {
+
+            baseline_path = args[++i];
+        } else if (!strcmp(args[i], "--tolerance") && has_value) {
+
+            tolerance = atof(args[++i]);
+        } else {
+
+            usage(args[0]);
+            return (EXIT_FAILURE);
+        }
+    }
+
+    for (auto const& name : rule_names) {
+
+        Rule rule;
+
+        if (parse_rule(name.c_str(), &rule))
+            return (EXIT_FAILURE);
+        rules.push_back(rule);
+    }
+
+    if (engines.empty()) {
+
+        for (char const *k : {"scalar", "sse2", "avx2", "lut"}) {
+
+            if (Board::use_kernel(k))
+                engines.push_back(std::string("dense-") + k);
+        }
+        engines.push_back("sparse");
+        engines.push_back("hashlife");
+    }
+
+    auto pool = std::make_shared<ThreadPool>(threads);
+    std::vector<Result> results;
+
+    for (auto const& engine : engines) {
+
+        for (auto const& size_str : sizes) {
+
+            int size = atoi(size_str.c_str());
+            /* roughly the same number of cell updates at every size */
+            uint64_t gens = (generations) ? generations
+                : std::max<uint64_t>(10, (uint64_t{1} << 28) / (uint64_t(size) * size));
+
+            for (auto const& w : workloads) {
+
+                if (!wanted(workload_filter, w.name))
+                    continue;
+
+                for (auto const& rule : rules) {
+
+                    double best = -1;
+
+                    for (int r = 0; r < repeat; r++) {
+
+                        double t;
+
+                        if (engine.rfind("dense-", 0) == 0) {
+
+                            if (!Board::use_kernel(engine.c_str() + 6)) {
+
+                                fprintf(stderr, "[ERROR] :: %s :: kernel %s unavailable\n",
+                                        __func__, engine.c_str() + 6);
+                                return (EXIT_FAILURE);
+                            }
+                            t = time_engine<Board>(w, size, seed, gens, rule, [&] {
+                                auto b = std::make_unique<Board>(size, size);
+                                b->set_pool(pool);
+                                return b;
+                            }, set_board);
+                        } else if (engine == "sparse") {
+
+                            t = time_engine<SparseUniverse>(w, size, seed, gens, rule, [] {
+                                return std::make_unique<SparseUniverse>();
+                            }, set_alive<SparseUniverse>);
+                        } else if (engine == "hashlife") {
+
+                            t = time_engine<HashLife>(w, size, seed, gens, rule, [] {
+                                return std::make_unique<HashLife>();
+                            }, set_alive<HashLife>);
+                        } else {
+
+                            fprintf(stderr, "[ERROR] :: %s :: unknown engine %s\n",
+                                    __func__, engine.c_str());
+                            return (EXIT_FAILURE);
+                        }
+
+                        if (best < 0 || t < best)
+                            best = t;
+                    }
+
+                    results.push_back({w.name, engine, rule_string(rule), size,
+                            gens, best});
+                    fprintf(stderr, "[INFO] :: %s :: %s %s %s %d: %.3fs\n", __func__,
+                            w.name, engine.c_str(), rule_string(rule).c_str(), size,
+                            best);
+                }
+            }
+        }
+    }
+
+    printf("{\n  \"threads\": %d,\n  \"seed\": %llu,\n  \"results\": [\n",
+            pool->size(), static_cast<unsigned long long>(seed));
+    for (size_t i = 0; i < results.size(); i++)
+        print_result(stdout, results[i], i + 1 == results.size());
+    printf("  ]\n}\n");
+
+    if (baseline_path) {
+
+        auto baseline = read_baseline(baseline_path);
+
+        for (auto const& r : results) {
+
+            auto it = baseline.find(r.workload + "/" + r.engine + "/" + r.rule
+                    + "/" + std::to_string(r.size));
+            double gps = (r.seconds > 0) ? r.generations / r.seconds : 0;
+
+            if (it == baseline.end() || it->second <= 0)
+                continue;
+
+            double ratio = gps / it->second;
+            bool regressed = ratio < 1.0 - tolerance;
+
+            fprintf(stderr, "[%s] :: %s :: %s %s %s %d: %.2fx baseline\n",
+                    regressed ? "REGRESSION" : "INFO", __func__,
+                    r.workload.c_str(), r.engine.c_str(), r.rule.c_str(), r.size,
+                    ratio);
+            if (regressed)
+                rc = EXIT_FAILURE;
+        }
+    }
+
+    return (rc);
+}
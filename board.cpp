@@ -0,0 +1,886 @@
+/**
+ * BOARD:
+ *  This file contains the bit-packed board and the word-at-a-time stepping
+ *  kernels for Conway's Game of Life and the other Life-like rules
+ *
+ *  Every kernel computes 64 cells per word by running the eight neighbour
+ *  bitboards through a bit-sliced adder. The same kernel body is compiled
+ *  for plain 64-bit words and, where the compiler supports vector
+ *  extensions, for SSE2 and AVX2 registers; the widest one the CPU supports
+ *  is picked the first time the board is stepped. Each of those is compiled
+ *  again for every rule in named_rules, plus once for rules only known at
+ *  run time, and a board steps with the one matching its rule.
+ *
+ *  The "lut" kernel is the exception: it steps two rows at once by looking
+ *  every 4x4 neighbourhood up in a table of 2x2 successors built for the
+ *  board's rule. It is never picked automatically, only by use_kernel().
+ *
+ *  file: board.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <bit>
+#include <map>
+#include <array>
+#include <mutex>
+#include <memory>
+#include <utility>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#include "board.hpp"
+#include "rule.hpp"
+#include "kernel.hpp"
+#include "threadpool.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define B_HAVE_VECTOR_KERNELS 1
+#endif
+
+#define B_BLOCK_TABLE_SIZE (1 << 16)
+
+using row_kernel = void (*)(uint64_t *, uint64_t const *, uint64_t const *,
+        uint64_t const *, int, uint32_t);
+
+template <uint32_t RULE>
+static inline void
+step_row_scalar(uint64_t *dst, uint64_t const *up, uint64_t const *mid,
+        uint64_t const *down, int begin, int end, uint32_t rule)
+{
+    for (int i = begin; i < end; i++) {
+
+        uint64_t n = up[i], c = mid[i], s = down[i];
+
+        life_kernel<RULE>(dst[i],
+                (n << 1) | (up[i - 1] >> 63), n, (n >> 1) | (up[i + 1] << 63),
+                (c << 1) | (mid[i - 1] >> 63), c, (c >> 1) | (mid[i + 1] << 63),
+                (s << 1) | (down[i - 1] >> 63), s, (s >> 1) | (down[i + 1] << 63),
+                rule);
+    }
+}
+
+template <uint32_t RULE>
+static void
+step_row_generic(uint64_t *dst, uint64_t const *up, uint64_t const *mid,
+        uint64_t const *down, int words, uint32_t rule)
+{
+    step_row_scalar<RULE>(dst, up, mid, down, 0, words, rule);
+}
+
+#ifdef B_HAVE_VECTOR_KERNELS
+
+/*
+ * the vector kernels process LANES consecutive words of a row at a time;
+ * the word either side of each lane is fetched with an unaligned load so
+ * the carries between words come for free
+ */
+template <uint32_t RULE, typename V, int LANES>
+static inline __attribute__((always_inline)) void
+step_row_vector(uint64_t *dst, uint64_t const *up, uint64_t const *mid,
+        uint64_t const *down, int words, uint32_t rule)
+{
+    int i = 0;
+
+    for (; i + LANES <= words; i += LANES) {
+
+        V n, nl, nr, c, cl, cr, s, sl, sr, r;
+
+        std::memcpy(&n, up + i, sizeof(V));
+        std::memcpy(&nl, up + i - 1, sizeof(V));
+        std::memcpy(&nr, up + i + 1, sizeof(V));
+        std::memcpy(&c, mid + i, sizeof(V));
+        std::memcpy(&cl, mid + i - 1, sizeof(V));
+        std::memcpy(&cr, mid + i + 1, sizeof(V));
+        std::memcpy(&s, down + i, sizeof(V));
+        std::memcpy(&sl, down + i - 1, sizeof(V));
+        std::memcpy(&sr, down + i + 1, sizeof(V));
+
+        life_kernel<RULE, V>(r, (n << 1) | (nl >> 63), n, (n >> 1) | (nr << 63),
+                (c << 1) | (cl >> 63), c, (c >> 1) | (cr << 63),
+                (s << 1) | (sl >> 63), s, (s >> 1) | (sr << 63), rule);
+        std::memcpy(dst + i, &r, sizeof(V));
+    }
+    step_row_scalar<RULE>(dst, up, mid, down, i, words, rule);
+}
+
+typedef uint64_t b_v2u64 __attribute__((vector_size(16)));
+typedef uint64_t b_v4u64 __attribute__((vector_size(32)));
+
+template <uint32_t RULE>
+__attribute__((target("sse2"))) static void
+step_row_sse2(uint64_t *dst, uint64_t const *up, uint64_t const *mid,
+        uint64_t const *down, int words, uint32_t rule)
+{
+    step_row_vector<RULE, b_v2u64, 2>(dst, up, mid, down, words, rule);
+}
+
+template <uint32_t RULE>
+__attribute__((target("avx2"))) static void
+step_row_avx2(uint64_t *dst, uint64_t const *up, uint64_t const *mid,
+        uint64_t const *down, int words, uint32_t rule)
+{
+    step_row_vector<RULE, b_v4u64, 4>(dst, up, mid, down, words, rule);
+}
+
+#endif
+
+/*
+ * the 2x2 successor of every 4x4 neighbourhood under a rule: bit r * 4 + c
+ * of the index is the cell at row r, column c, and bits 0-3 of the entry
+ * are the centre cells (1, 1), (1, 2), (2, 1), (2, 2). Tables are built the
+ * first time a rule needs one and kept for the life of the program
+ */
+static uint8_t const *
+block_table(Rule const& rule)
+{
+    static std::mutex lock;
+    static std::map<uint32_t, std::unique_ptr<uint8_t[]>> tables;
+    std::lock_guard<std::mutex> guard(lock);
+    auto& table = tables[rule.bits()];
+
+    if (table)
+        return (table.get());
+
+    table = std::make_unique<uint8_t[]>(B_BLOCK_TABLE_SIZE);
+    for (uint32_t index = 0; index < B_BLOCK_TABLE_SIZE; index++) {
+
+        uint8_t next = 0;
+
+        for (int out = 0; out < 4; out++) {
+
+            int r = 1 + (out >> 1);
+            int c = 1 + (out & 1);
+            int count = 0;
+
+            for (int dr = -1; dr <= 1; dr++) {
+
+                for (int dc = -1; dc <= 1; dc++) {
+
+                    if (dr || dc)
+                        count += (index >> ((r + dr) * 4 + c + dc)) & 1;
+                }
+            }
+
+            uint16_t mask = ((index >> (r * 4 + c)) & 1) ? rule.survive : rule.birth;
+            next |= ((mask >> count) & 1) << out;
+        }
+        table[index] = next;
+    }
+
+    return (table.get());
+}
+
+/*
+ * steps rows top and bottom from the four rows around them, two columns at
+ * a time: each pair of cells is one table lookup on the 4x4 block of
+ * neighbourhood bits, gathered a nibble per row
+ */
+static void
+step_pair_lut(uint64_t *top, uint64_t *bottom, uint64_t const *const rows[4],
+        int words, uint8_t const *table)
+{
+    for (int i = 0; i < words; i++) {
+
+        uint64_t from_west[4];
+        uint64_t east[4];
+        uint64_t t = 0;
+        uint64_t b = 0;
+
+        /* shifted left by one, so bits 2k to 2k + 3 are columns 2k - 1 to 2k + 2 */
+        for (int r = 0; r < 4; r++) {
+
+            from_west[r] = (rows[r][i] << 1) | (rows[r][i - 1] >> 63);
+            east[r] = (rows[r][i] >> 61) | ((rows[r][i + 1] & 1) << 3);
+        }
+
+        for (int k = 0; k < 32; k++) {
+
+            uint32_t index = 0;
+
+            for (int r = 0; r < 4; r++) {
+
+                uint32_t nibble = (k < 31) ? (from_west[r] >> (2 * k)) & 0xF
+                                           : static_cast<uint32_t>(east[r]);
+                index |= nibble << (4 * r);
+            }
+
+            uint64_t next = table[index];
+            t |= (next & 3) << (2 * k);
+            b |= (next >> 2) << (2 * k);
+        }
+
+        top[i] = t;
+        bottom[i] = b;
+    }
+}
+
+/* the kernel for each named rule, in named_rules order, then the run-time one */
+#define B_RUNTIME_KERNEL R_NAMED_RULES
+
+using pair_kernel = void (*)(uint64_t *, uint64_t *, uint64_t const *const [4],
+        int, uint8_t const *);
+
+struct KernelChoice {
+    std::array<row_kernel, R_NAMED_RULES + 1> fns;
+    char const *name;
+    pair_kernel pairs;          /* steps two rows at a time instead of fns */
+};
+
+template <size_t... I>
+static constexpr auto
+make_kernels(std::index_sequence<I...>)
+{
+    return std::to_array<KernelChoice>({
+#ifdef B_HAVE_VECTOR_KERNELS
+        {{step_row_avx2<named_rules[I].rule.bits()>...,
+            step_row_avx2<K_RUNTIME>}, "avx2", nullptr},
+        {{step_row_sse2<named_rules[I].rule.bits()>...,
+            step_row_sse2<K_RUNTIME>}, "sse2", nullptr},
+#endif
+        {{step_row_generic<named_rules[I].rule.bits()>...,
+            step_row_generic<K_RUNTIME>}, "scalar", nullptr},
+        {{}, "lut", step_pair_lut},
+    });
+}
+
+/* every kernel this build has, widest first, then the opt-in ones */
+static constexpr auto kernels =
+    make_kernels(std::make_index_sequence<R_NAMED_RULES>());
+
+static bool
+kernel_supported(KernelChoice const& kernel)
+{
+#ifdef B_HAVE_VECTOR_KERNELS
+    __builtin_cpu_init();
+    if (!strcmp(kernel.name, "avx2"))
+        return (__builtin_cpu_supports("avx2"));
+    if (!strcmp(kernel.name, "sse2"))
+        return (__builtin_cpu_supports("sse2"));
+#endif
+    return (!strcmp(kernel.name, "scalar") || !strcmp(kernel.name, "lut"));
+}
+
+static KernelChoice const *
+best_kernel(void)
+{
+    for (auto const& kernel : kernels) {
+
+        if (kernel_supported(kernel) && !kernel.pairs)
+            return (&kernel);
+    }
+
+    return (&kernels.back());
+}
+
+/* chosen once at start-up, before any board can be stepped */
+static KernelChoice const *active = best_kernel();
+
+static KernelChoice const&
+active_kernel(void)
+{
+    return (*active);
+}
+
+/*
+ * one word's share of the board hash: the word, keyed by its index in the
+ * board, folded through a 64x64 to 128-bit multiply where the compiler has
+ * one, or a splitmix64 finaliser where it does not. Empty words add
+ * nothing, so an empty board hashes to 0
+ */
+static inline uint64_t
+word_hash(size_t index, uint64_t word)
+{
+    if (!word)
+        return (0);
+
+    uint64_t key = word ^ (index * 0x9e3779b97f4a7c15);
+
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 z = static_cast<unsigned __int128>(key) * 0xbf58476d1ce4e5b9;
+    return (static_cast<uint64_t>(z) ^ static_cast<uint64_t>(z >> 64));
+#else
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111eb;
+    return (key ^ (key >> 31));
+#endif
+}
+
+Board::Board(int width, int height)
+{
+    this->b_width = width;
+    this->b_height = height;
+    this->b_words = (width + 63) / 64;
+    this->b_stride = this->b_words + 2;
+    this->b_tail_mask = (width % 64) ? ((uint64_t{1} << (width % 64)) - 1)
+                                     : ~uint64_t{0};
+    this->b_width_mask = (std::has_single_bit(unsigned(width))) ? width - 1 : 0;
+    this->b_height_mask = (std::has_single_bit(unsigned(height))) ? height - 1 : 0;
+    this->b_pow2 = this->b_width_mask && this->b_height_mask && width >= 64
+        && height >= B_TILE_ROWS;
+    this->b_cells = std::vector<uint64_t>(
+            static_cast<size_t>(this->b_stride) * height);
+    this->b_next = std::vector<uint64_t>(
+            static_cast<size_t>(this->b_stride) * height);
+    this->b_tiles_x = this->b_words;
+    this->b_tiles_y = (height + B_TILE_ROWS - 1) / B_TILE_ROWS;
+    this->b_changed = std::vector<uint8_t>(
+            static_cast<size_t>(this->b_tiles_x) * this->b_tiles_y);
+    this->b_active = std::vector<uint8_t>(this->b_changed.size());
+    this->b_dirty = std::vector<uint8_t>(this->b_changed.size(), 1);
+    this->b_generation = 0;
+    this->b_hashing = false;
+    this->b_hash = 0;
+    this->b_band_hash = std::vector<uint64_t>(this->b_tiles_y);
+    this->b_lut = nullptr;
+    this->set_rule(R_CONWAY);
+}
+
+/* picks the kernel compiled for the rule, or the run-time one if there is none */
+void
+Board::set_rule(Rule const& rule)
+{
+    int named = named_rule_index(rule);
+
+    this->b_rule = rule;
+    this->b_rule_kernel = (named < 0) ? B_RUNTIME_KERNEL : named;
+}
+
+int
+Board::wrap_x(int x) const
+{
+    if (this->b_width_mask)
+        return (x & this->b_width_mask);
+    if (x >= 0 && x < this->b_width) [[likely]]
+        return (x);
+
+    int mod = x % this->b_width;
+    return (mod < 0) ? (mod + this->b_width) : (mod);
+}
+
+int
+Board::wrap_y(int y) const
+{
+    if (this->b_height_mask)
+        return (y & this->b_height_mask);
+    if (y >= 0 && y < this->b_height) [[likely]]
+        return (y);
+
+    int mod = y % this->b_height;
+    return (mod < 0) ? (mod + this->b_height) : (mod);
+}
+
+uint8_t
+Board::get(int x, int y) const
+{
+    int b_x = this->wrap_x(x);
+    int b_y = this->wrap_y(y);
+
+    return (this->row(b_y)[b_x >> 6] >> (b_x & 63)) & 1;
+}
+
+void
+Board::set(int x, int y, uint8_t val)
+{
+    int b_x = this->wrap_x(x);
+    int b_y = this->wrap_y(y);
+    uint64_t *word = this->row_of(this->b_cells, b_y) + (b_x >> 6);
+    uint64_t bit = uint64_t{1} << (b_x & 63);
+
+    this->change_word(word, static_cast<size_t>(b_y) * this->b_words + (b_x >> 6),
+            (val) ? *word | bit : *word & ~bit);
+    size_t tile = (b_y / B_TILE_ROWS) * this->b_tiles_x + (b_x >> 6);
+
+    this->b_changed[tile] = 1;
+    this->b_dirty[tile] = 1;
+}
+
+/*
+ * brings count cells to life running east from (x, y), a word at a time;
+ * the run must lie inside the board
+ */
+void
+Board::set_run(int x, int y, int count)
+{
+    uint64_t *r = this->row_of(this->b_cells, y);
+    int tile_row = (y / B_TILE_ROWS) * this->b_tiles_x;
+
+    while (count > 0) {
+
+        int bit = x & 63;
+        int span = std::min(count, 64 - bit);
+        uint64_t mask = (span == 64) ? ~uint64_t{0}
+                                     : ((uint64_t{1} << span) - 1) << bit;
+
+        this->change_word(&r[x >> 6],
+                static_cast<size_t>(y) * this->b_words + (x >> 6), r[x >> 6] | mask);
+        this->b_changed[tile_row + (x >> 6)] = 1;
+        this->b_dirty[tile_row + (x >> 6)] = 1;
+        x += span;
+        count -= span;
+    }
+}
+
+/* replaces the i-th word of row y, the cells from 64 * i to 64 * i + 63 */
+void
+Board::set_word(int i, int y, uint64_t word)
+{
+    size_t tile = (y / B_TILE_ROWS) * this->b_tiles_x + i;
+
+    if (i == this->b_words - 1)
+        word &= this->b_tail_mask;
+    this->change_word(this->row_of(this->b_cells, y) + i,
+            static_cast<size_t>(y) * this->b_words + i, word);
+    this->b_changed[tile] = 1;
+    this->b_dirty[tile] = 1;
+}
+
+/* sets (value 1) or clears the cells of mask in the i-th word of row y */
+void
+Board::stamp_word(int i, int y, uint64_t mask, uint8_t value)
+{
+    uint64_t *word = this->row_of(this->b_cells, y) + i;
+    uint64_t next = (value) ? *word | mask : *word & ~mask;
+    size_t tile = (y / B_TILE_ROWS) * this->b_tiles_x + i;
+
+    if (next == *word)
+        return;
+    this->change_word(word, static_cast<size_t>(y) * this->b_words + i, next);
+    this->b_changed[tile] = 1;
+    this->b_dirty[tile] = 1;
+}
+
+/*
+ * brings to life (value 1) or kills the live cells of a width x height
+ * bitmap, packed (width + 63) / 64 words to a row, with its top-left at
+ * (x, y) and wrapping around the torus; its dead cells are left alone.
+ * Each word of the bitmap is shifted into the one or two board words
+ * under it, and split where it crosses the right edge of the board
+ */
+void
+Board::stamp(int x, int y, uint64_t const *bits, int width, int height,
+        uint8_t value)
+{
+    int words = (width + 63) / 64;
+
+    for (int r = 0; r < height; r++) {
+
+        uint64_t const *src = bits + static_cast<size_t>(r) * words;
+        int by = this->wrap_y(y + r);
+
+        for (int i = 0; i < words; i++) {
+
+            uint64_t cells = src[i];
+            int bx = this->wrap_x(x + i * 64);
+
+            while (cells) {
+
+                int span = std::min(64, this->b_width - bx);
+                uint64_t part = (span == 64) ? cells
+                    : cells & ((uint64_t{1} << span) - 1);
+                int shift = bx & 63;
+
+                if (part) {
+
+                    this->stamp_word(bx >> 6, by, part << shift, value);
+                    if (shift && part >> (64 - shift))
+                        this->stamp_word((bx >> 6) + 1, by, part >> (64 - shift),
+                                value);
+                }
+                cells = (span == 64) ? 0 : cells >> span;
+                bx = 0;
+            }
+        }
+    }
+}
+
+void
+Board::clear(void)
+{
+    std::fill(this->b_cells.begin(), this->b_cells.end(), 0);
+    std::fill(this->b_changed.begin(), this->b_changed.end(), 1);
+    std::fill(this->b_dirty.begin(), this->b_dirty.end(), 1);
+    this->b_generation = 0;
+    this->b_hash = 0;
+}
+
+/*
+ * replaces every cell with cells, packed words() words to a row with no
+ * halo, and takes the generation count those cells were at
+ */
+void
+Board::restore(uint64_t const *cells, uint64_t generation)
+{
+    for (int y = 0; y < this->b_height; y++) {
+
+        uint64_t *r = this->row_of(this->b_cells, y);
+
+        memcpy(r, cells + static_cast<size_t>(y) * this->b_words,
+                this->b_words * sizeof(uint64_t));
+        r[this->b_words - 1] &= this->b_tail_mask;
+    }
+    std::fill(this->b_changed.begin(), this->b_changed.end(), 1);
+    std::fill(this->b_dirty.begin(), this->b_dirty.end(), 1);
+    this->b_generation = generation;
+
+    if (this->b_hashing) {
+
+        this->b_hashing = false;
+        this->track_hash();
+    }
+}
+
+/* stores value at word, the index-th word of the board, keeping the hash */
+void
+Board::change_word(uint64_t *word, size_t index, uint64_t value)
+{
+    if (this->b_hashing) {
+
+        uint64_t mask = (index % this->b_words == size_t(this->b_words - 1))
+            ? this->b_tail_mask : ~uint64_t{0};
+
+        this->b_hash ^= word_hash(index, *word & mask)
+            ^ word_hash(index, value & mask);
+    }
+    *word = value;
+}
+
+/*
+ * makes the torus look flat to the kernel: the halo word before each row
+ * carries the row's last cell in its top bit, and the cell just past the
+ * row's end (a spare bit of the last word, or the halo word after the row
+ * when the width is a multiple of 64) carries the row's first cell
+ */
+template <bool POW2>
+void
+Board::fill_halo(void)
+{
+    int last = this->b_width - 1;
+    int tail = (POW2) ? 0 : this->b_width % 64;
+
+    for (int y = 0; y < this->b_height; y++) {
+
+        uint64_t *r = this->row_of(this->b_cells, y);
+        uint64_t first_cell = r[0] & 1;
+        uint64_t last_cell = (r[last >> 6] >> (last & 63)) & 1;
+
+        r[-1] = last_cell << 63;
+        if (!POW2 && tail) {
+
+            r[this->b_words - 1] = (r[this->b_words - 1] & this->b_tail_mask)
+                | (first_cell << tail);
+            r[this->b_words] = 0;
+        } else {
+
+            r[this->b_words] = first_cell;
+        }
+    }
+}
+
+/*
+ * a tile has to be recomputed when it or any tile around it changed in the
+ * last generation; every other tile is already correct in b_next, which
+ * holds the generation before this one
+ */
+template <bool POW2>
+void
+Board::mark_active(void)
+{
+    for (int ty = 0; ty < this->b_tiles_y; ty++) {
+
+        for (int tx = 0; tx < this->b_tiles_x; tx++) {
+
+            uint8_t active = 0;
+
+            for (int dy = -1; dy <= 1 && !active; dy++) {
+
+                int ny = (POW2) ? (ty + dy) & (this->b_tiles_y - 1)
+                    : (ty + dy + this->b_tiles_y) % this->b_tiles_y;
+
+                for (int dx = -1; dx <= 1 && !active; dx++) {
+
+                    int nx = (POW2) ? (tx + dx) & (this->b_tiles_x - 1)
+                        : (tx + dx + this->b_tiles_x) % this->b_tiles_x;
+                    active = this->b_changed[ny * this->b_tiles_x + nx];
+                }
+            }
+            this->b_active[ty * this->b_tiles_x + tx] = active;
+        }
+    }
+}
+
+/*
+ * wraps a row index that is at most one board height below range, or any
+ * distance above it; rows past the end are rare enough to take a modulo,
+ * which also covers the pair kernels reading two rows ahead on a one-row
+ * board
+ */
+template <bool POW2>
+int
+Board::wrap_row(int y) const
+{
+    if (POW2)
+        return (y & this->b_height_mask);
+    if (y < 0)
+        return (y + this->b_height);
+
+    return (y >= this->b_height) ? y % this->b_height : y;
+}
+
+/*
+ * steps the rows of one band of tiles, reading only b_cells. Row kernels
+ * go a row at a time; pair kernels two, with the second row of an odd last
+ * row going to a scratch row
+ */
+template <bool POW2>
+void
+Board::step_band(int ty)
+{
+    KernelChoice const& choice = active_kernel();
+    row_kernel kernel = choice.fns[this->b_rule_kernel];
+    int rows = (choice.pairs) ? 2 : 1;
+    uint32_t rule = this->b_rule.bits();
+    int tile_row = ty * this->b_tiles_x;
+    uint8_t const *active = &this->b_active[tile_row];
+    uint8_t *changed = &this->b_changed[tile_row];
+    int last_row = std::min(this->b_height, (ty + 1) * B_TILE_ROWS);
+    uint64_t hash = 0;
+    std::vector<uint64_t> scratch;
+
+    for (int y = ty * B_TILE_ROWS; y < last_row; y += rows) {
+
+        uint64_t const *around[4];
+        uint64_t *dst[2] = {this->row_of(this->b_next, y), nullptr};
+        uint64_t const *src[2] = {this->row_of(this->b_cells, y), nullptr};
+        int count = std::min(rows, last_row - y);
+
+        for (int r = 0; r < rows + 2; r++)
+            around[r] = this->row_of(this->b_cells, this->wrap_row<POW2>(y - 1 + r));
+        if (count == 2) {
+
+            dst[1] = this->row_of(this->b_next, y + 1);
+            src[1] = this->row_of(this->b_cells, y + 1);
+        } else if (rows == 2) {
+
+            scratch.resize(this->b_stride);
+            dst[1] = scratch.data() + 1;
+        }
+
+        /* run the kernel over each stretch of consecutive active tiles */
+        for (int begin = 0; begin < this->b_tiles_x;) {
+
+            if (!active[begin]) {
+
+                begin++;
+                continue;
+            }
+
+            int end = begin + 1;
+            while (end < this->b_tiles_x && active[end])
+                end++;
+
+            if (choice.pairs) {
+
+                uint64_t const *block[4] = {around[0] + begin, around[1] + begin,
+                    around[2] + begin, around[3] + begin};
+
+                choice.pairs(dst[0] + begin, dst[1] + begin, block, end - begin,
+                        this->b_lut);
+            } else {
+
+                kernel(dst[0] + begin, around[0] + begin, around[1] + begin,
+                        around[2] + begin, end - begin, rule);
+            }
+
+            for (int r = 0; r < count; r++) {
+
+                size_t index = static_cast<size_t>(y + r) * this->b_words;
+
+                for (int i = begin; i < end; i++) {
+
+                    uint64_t mask = (!POW2 && i == this->b_words - 1)
+                        ? this->b_tail_mask : ~uint64_t{0};
+                    uint64_t before = src[r][i] & mask;
+                    uint64_t after = dst[r][i] & mask;
+
+                    if (before == after)
+                        continue;
+                    changed[i] = 1;
+                    if (this->b_hashing)
+                        hash ^= word_hash(index + i, before)
+                            ^ word_hash(index + i, after);
+                }
+            }
+            begin = end;
+        }
+        /* whole-word rows have no ghost bit to clear */
+        for (int r = 0; !POW2 && r < count; r++)
+            dst[r][this->b_words - 1] &= this->b_tail_mask;
+    }
+    this->b_band_hash[ty] = hash;
+}
+
+/*
+ * bands only write their own rows of b_next, their own tile flags and their
+ * own hash change, and only read b_cells, so they can run in any order on
+ * any thread and still give the same generation
+ */
+template <bool POW2>
+void
+Board::step_generation(void)
+{
+    this->fill_halo<POW2>();
+    this->mark_active<POW2>();
+    std::fill(this->b_changed.begin(), this->b_changed.end(), 0);
+    if (active_kernel().pairs)
+        this->b_lut = block_table(this->b_rule);
+
+    if (this->b_pool && this->b_tiles_y > 1) {
+
+        this->b_pool->parallel_for(this->b_tiles_y, [this](int ty) {
+            this->step_band<POW2>(ty);
+        });
+    } else {
+
+        for (int ty = 0; ty < this->b_tiles_y; ty++)
+            this->step_band<POW2>(ty);
+    }
+
+    for (size_t i = 0; i < this->b_dirty.size(); i++)
+        this->b_dirty[i] |= this->b_changed[i];
+    for (uint64_t change : this->b_band_hash)
+        this->b_hash ^= change;
+
+    std::swap(this->b_cells, this->b_next);
+    this->b_generation++;
+}
+
+void
+Board::step(void)
+{
+    if (this->b_pow2)
+        this->step_generation<true>();
+    else
+        this->step_generation<false>();
+}
+
+void
+Board::advance(uint64_t generations)
+{
+    while (generations--)
+        this->step();
+}
+
+/*
+ * moves the generation count on without stepping, for when the caller knows
+ * the board would be back where it is after that many generations (a
+ * multiple of the period of a cycle it has entered)
+ */
+void
+Board::fast_forward(uint64_t generations)
+{
+    this->b_generation += generations;
+}
+
+/* starts keeping hash() current, working it out from scratch the first time */
+void
+Board::track_hash(void)
+{
+    if (this->b_hashing)
+        return;
+
+    this->b_hashing = true;
+    this->b_hash = 0;
+    for (int y = 0; y < this->b_height; y++) {
+
+        uint64_t const *cur = this->row(y);
+
+        for (int i = 0; i < this->b_words; i++) {
+
+            uint64_t mask = (i == this->b_words - 1) ? this->b_tail_mask
+                                                     : ~uint64_t{0};
+            this->b_hash ^= word_hash(static_cast<size_t>(y) * this->b_words + i,
+                    cur[i] & mask);
+        }
+    }
+}
+
+uint64_t
+Board::population(void) const
+{
+    uint64_t population = 0;
+
+    for (int y = 0; y < this->b_height; y++) {
+
+        uint64_t const *cur = this->row(y);
+
+        for (int i = 0; i < this->b_words; i++)
+            population += std::popcount(cur[i]);
+    }
+
+    return (population);
+}
+
+/*
+ * adds the cells born and the cells that died in the last generation to
+ * births and deaths, reading only the tiles it changed
+ */
+void
+Board::count_changes(uint64_t *births, uint64_t *deaths) const
+{
+    for (int y = 0; y < this->b_height; y++) {
+
+        uint64_t const *cur = this->row(y);
+        uint64_t const *prev = this->previous_row(y);
+
+        for (int i = 0; i < this->b_words; i++) {
+
+            if (!this->tile_changed(i, y / B_TILE_ROWS))
+                continue;
+
+            uint64_t mask = (i == this->b_words - 1) ? this->b_tail_mask
+                                                     : ~uint64_t{0};
+
+            *births += std::popcount(cur[i] & ~prev[i] & mask);
+            *deaths += std::popcount(prev[i] & ~cur[i] & mask);
+        }
+    }
+}
+
+void
+Board::clear_dirty(void)
+{
+    std::fill(this->b_dirty.begin(), this->b_dirty.end(), 0);
+}
+
+void
+Board::set_pool(std::shared_ptr<ThreadPool> pool)
+{
+    this->b_pool = std::move(pool);
+}
+
+char const *
+Board::kernel_name(void)
+{
+    return (active_kernel().name);
+}
+
+/*
+ * forces every board onto the named kernel ("scalar", "sse2", "avx2" or
+ * "lut"), as long as this build and CPU support it
+ */
+bool
+Board::use_kernel(char const *name)
+{
+    for (auto const& kernel : kernels) {
+
+        if (!strcmp(kernel.name, name) && kernel_supported(kernel)) {
+
+            active = &kernel;
+            return (true);
+        }
+    }
+
+    return (false);
+}
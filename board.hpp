@@ -0,0 +1,216 @@
+/**
+ * BOARD:
+ *  This file contains all prototypes and utilities needed for the bit-packed
+ *  toroidal board that Conway's Game of Life, or any other Life-like rule,
+ *  is simulated on
+ *
+ *  Each row of the board is stored as a run of 64-bit words, one bit per
+ *  cell, with a halo word on either side of the row so the stepping kernel
+ *  can read its west and east neighbours without any bounds checks.
+ *
+ *  The board is also split into tiles one word wide and B_TILE_ROWS tall,
+ *  each flagged when it changed in the last generation. Only tiles that
+ *  changed, or border one that did, are recomputed by step(), so settled
+ *  debris costs nothing to keep. Each band of tiles is independent, so
+ *  with a ThreadPool attached the bands are stepped in parallel.
+ *
+ *  Once track_hash() is called the board also keeps a 64-bit hash of its
+ *  cells, the XOR of a mix of every word with its position. set() and
+ *  step() patch it for the words they change, so it stays current at the
+ *  cost of the activity, and two generations with equal hashes can be
+ *  taken to be the same board. Boards nobody hashes skip that work.
+ *
+ *  The dimensions are chosen at runtime. Boards whose sides are both
+ *  powers of two (of at least 64) take a specialised step where rows fill
+ *  whole words and every wrap is a mask instead of a modulo or a branch.
+ *
+ *  file: board.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <bit>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "rule.hpp"
+
+#define B_TILE_ROWS 64
+
+class ThreadPool;
+
+/* a read-only look at packed rows that belong to someone else */
+struct BoardView {
+    uint64_t const *cells;      /* first word of row 0 */
+    size_t stride;              /* words from one row to the next */
+    int width;
+    int height;
+    int words;
+
+    [[ nodiscard ]] uint64_t const *row(int y) const
+    {
+        return this->cells + static_cast<size_t>(y) * this->stride;
+    }
+};
+
+class Board
+{
+    private:
+        int b_width;
+        int b_height;
+        int b_words;                /* packed words holding one row */
+        int b_stride;               /* b_words plus a halo word each side */
+        uint64_t b_tail_mask;       /* live bits of the last word in a row */
+        bool b_pow2;                /* both sides powers of two, at least 64 */
+        int b_width_mask;           /* width - 1 when a power of two, else 0 */
+        int b_height_mask;
+        std::vector<uint64_t> b_cells;
+        std::vector<uint64_t> b_next;
+        int b_tiles_x;
+        int b_tiles_y;
+        std::vector<uint8_t> b_changed;     /* tile changed last generation */
+        std::vector<uint8_t> b_active;      /* tile is recomputed this step */
+        std::vector<uint8_t> b_dirty;       /* tile changed since clear_dirty() */
+        std::shared_ptr<ThreadPool> b_pool;
+        uint64_t b_generation;
+        bool b_hashing;                     /* step() keeps b_hash current */
+        uint64_t b_hash;
+        std::vector<uint64_t> b_band_hash;  /* hash change of each band's step */
+        Rule b_rule;
+        size_t b_rule_kernel;               /* index of the rule's kernel */
+        uint8_t const *b_lut;               /* the rule's block table, for "lut" */
+
+        template <bool POW2> void fill_halo(void);
+        template <bool POW2> void mark_active(void);
+        template <bool POW2> [[ nodiscard ]] int wrap_row(int) const;
+        template <bool POW2> void step_band(int);
+        template <bool POW2> void step_generation(void);
+        void change_word(uint64_t *, size_t, uint64_t);
+        void stamp_word(int, int, uint64_t, uint8_t);
+
+        [[ nodiscard ]] uint64_t *row_of(std::vector<uint64_t>& buf, int y)
+        {
+            return buf.data() + static_cast<size_t>(y) * this->b_stride + 1;
+        }
+
+    public:
+        Board(int, int);
+
+        [[ nodiscard ]] int width(void) const { return this->b_width; }
+        [[ nodiscard ]] int height(void) const { return this->b_height; }
+        [[ nodiscard ]] int words(void) const { return this->b_words; }
+        [[ nodiscard ]] uint64_t tail_mask(void) const { return this->b_tail_mask; }
+        [[ nodiscard ]] int tiles_x(void) const { return this->b_tiles_x; }
+        [[ nodiscard ]] int tiles_y(void) const { return this->b_tiles_y; }
+        [[ nodiscard ]] bool pow2(void) const { return this->b_pow2; }
+
+        [[ nodiscard ]] bool tile_changed(int tx, int ty) const
+        {
+            return this->b_changed[ty * this->b_tiles_x + tx] != 0;
+        }
+
+        /* tiles that changed in any way since the last clear_dirty() */
+        [[ nodiscard ]] uint8_t const *dirty_tiles(void) const { return this->b_dirty.data(); }
+        void clear_dirty(void);
+
+        [[ nodiscard ]] int wrap_x(int) const;
+        [[ nodiscard ]] int wrap_y(int) const;
+
+        [[ nodiscard ]] uint8_t get(int, int) const;
+        void set(int, int, uint8_t);
+        void set_run(int, int, int);
+        void set_word(int, int, uint64_t);
+        void stamp(int, int, uint64_t const *, int, int, uint8_t);
+        void clear(void);
+        void restore(uint64_t const *, uint64_t);
+        void step(void);
+        void advance(uint64_t);
+        void fast_forward(uint64_t);
+        void set_pool(std::shared_ptr<ThreadPool>);
+        void set_rule(Rule const&);
+        [[ nodiscard ]] Rule const& rule(void) const { return this->b_rule; }
+
+        [[ nodiscard ]] uint64_t const *row(int y) const
+        {
+            return this->b_cells.data()
+                + static_cast<size_t>(y) * this->b_stride + 1;
+        }
+
+        [[ nodiscard ]] uint64_t const *previous_row(int y) const
+        {
+            return this->b_next.data()
+                + static_cast<size_t>(y) * this->b_stride + 1;
+        }
+
+        [[ nodiscard ]] BoardView view(void) const
+        {
+            return {this->row(0), static_cast<size_t>(this->b_stride),
+                this->b_width, this->b_height, this->b_words};
+        }
+
+        [[ nodiscard ]] uint64_t generation(void) const { return this->b_generation; }
+        void set_generation(uint64_t generation) { this->b_generation = generation; }
+        void track_hash(void);
+        [[ nodiscard ]] uint64_t hash(void) const { return this->b_hash; }
+        [[ nodiscard ]] uint64_t population(void) const;
+        void count_changes(uint64_t *, uint64_t *) const;
+        [[ nodiscard ]] static char const *kernel_name(void);
+        static bool use_kernel(char const *);
+
+        /* calls fn(x, y) for every live cell, in row order */
+        template <typename F>
+        void for_each_alive(F&& fn) const
+        {
+            for (int y = 0; y < this->b_height; y++) {
+
+                uint64_t const *cur = this->row(y);
+
+                for (int i = 0; i < this->b_words; i++) {
+
+                    uint64_t word = cur[i];
+
+                    while (word) {
+
+                        fn(i * 64 + std::countr_zero(word), y);
+                        word &= word - 1;
+                    }
+                }
+            }
+        }
+
+        /*
+         * calls fn(x, y, alive) for every cell that differs between the
+         * current generation and the one before it
+         */
+        template <typename F>
+        void for_each_change(F&& fn) const
+        {
+            for (int y = 0; y < this->b_height; y++) {
+
+                uint64_t const *cur = this->row(y);
+                uint64_t const *prev = this->previous_row(y);
+
+                for (int i = 0; i < this->b_words; i++) {
+
+                    if (!this->tile_changed(i, y / B_TILE_ROWS))
+                        continue;
+
+                    uint64_t diff = cur[i] ^ prev[i];
+
+                    if (i == this->b_words - 1)
+                        diff &= this->b_tail_mask;
+
+                    while (diff) {
+
+                        int bit = std::countr_zero(diff);
+                        fn(i * 64 + bit, y, (cur[i] >> bit) & 1);
+                        diff &= diff - 1;
+                    }
+                }
+            }
+        }
+};
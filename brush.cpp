@@ -0,0 +1,158 @@
+/**
+ * BRUSH:
+ *  This file contains the brushes cells are drawn onto the board with
+ *
+ *  file: brush.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+#include "brush.hpp"
+#include "pattern.hpp"
+
+/* the brushes every window starts with: name, cursor cell, cells */
+static struct {
+    char const *name;
+    int x;
+    int y;
+    char const *cells;
+} const builtins[] = {
+    {"cell",    0, 0, "O"},
+    {"block",   0, 0, "OO\nOO"},
+    {"beehive", 1, 1, ".OO.\nO..O\n.OO."},
+    {"loaf",    1, 1, ".OO.\nO..O\n.O.O\n..O."},
+    {"boat",    1, 1, "OO.\nO.O\n.O."},
+    {"tub",     1, 1, ".O.\nO.O\n.O."},
+    {"blinker", 0, 1, "O\nO\nO"},
+    {"toad",    1, 1, ".OOO\nOOO."},
+    {"beacon",  1, 2, "OO..\nO...\n...O\n..OO"},
+    {"glider",  1, 2, ".O.\n..O\nOOO"},
+};
+
+/* collects a pattern's runs, since its extent is only known at the end */
+class RunSink : public PatternSink
+{
+    private:
+        std::vector<Brush::Run>& s_runs;
+
+    public:
+        explicit RunSink(std::vector<Brush::Run>& runs) : s_runs(runs) {}
+
+        void set_run(int64_t x, int64_t y, int64_t count) override
+        {
+            this->s_runs.push_back({x, y, count});
+        }
+};
+
+Brush::Brush(void)
+{
+    this->br_width = 0;
+    this->br_height = 0;
+    this->br_words = 0;
+    this->br_x = 0;
+    this->br_y = 0;
+    this->br_cells = 0;
+}
+
+/* packs runs into the bitmap, trimmed to the live cells' bounding box */
+int
+Brush::build(std::vector<Run> const& runs)
+{
+    int64_t x0 = INT64_MAX;
+    int64_t y0 = INT64_MAX;
+    int64_t x1 = INT64_MIN;
+    int64_t y1 = INT64_MIN;
+
+    for (Run const& run : runs) {
+
+        x0 = std::min(x0, run.x);
+        y0 = std::min(y0, run.y);
+        x1 = std::max(x1, run.x + run.count - 1);
+        y1 = std::max(y1, run.y);
+    }
+
+    if (runs.empty()) {
+
+        fprintf(stderr, "[ERROR] :: %s :: brush %s has no live cells\n",
+                __func__, this->br_name.c_str());
+        return (EXIT_FAILURE);
+    }
+    if (x1 - x0 >= BR_MAX_SIZE || y1 - y0 >= BR_MAX_SIZE) {
+
+        fprintf(stderr, "[ERROR] :: %s :: brush %s is over %d cells across\n",
+                __func__, this->br_name.c_str(), BR_MAX_SIZE);
+        return (EXIT_FAILURE);
+    }
+
+    this->br_width = static_cast<int>(x1 - x0 + 1);
+    this->br_height = static_cast<int>(y1 - y0 + 1);
+    this->br_words = (this->br_width + 63) / 64;
+    this->br_bits.assign(static_cast<size_t>(this->br_words) * this->br_height, 0);
+    this->br_cells = 0;
+
+    for (Run const& run : runs) {
+
+        uint64_t *row = this->br_bits.data()
+            + static_cast<size_t>(run.y - y0) * this->br_words;
+
+        for (int64_t x = run.x - x0; x < run.x - x0 + run.count; x++)
+            row[x >> 6] |= uint64_t{1} << (x & 63);
+    }
+    for (uint64_t word : this->br_bits)
+        this->br_cells += std::popcount(word);
+
+    return (EXIT_SUCCESS);
+}
+
+/* reads a brush from any pattern file, placed centred on the cursor */
+int
+Brush::load(char const *path)
+{
+    std::vector<Run> runs;
+    RunSink sink(runs);
+
+    this->br_name = std::filesystem::path(path).stem().string();
+    if (read_pattern(path, sink) || this->build(runs))
+        return (EXIT_FAILURE);
+
+    this->br_x = this->br_width / 2;
+    this->br_y = this->br_height / 2;
+    return (EXIT_SUCCESS);
+}
+
+/* reads a brush from pattern text, with cell (x, y) of it under the cursor */
+int
+Brush::parse(char const *name, char const *text, int x, int y)
+{
+    std::vector<Run> runs;
+    RunSink sink(runs);
+
+    this->br_name = name;
+    if (read_pattern_text(text, strlen(text), sink) || this->build(runs))
+        return (EXIT_FAILURE);
+
+    this->br_x = x;
+    this->br_y = y;
+    return (EXIT_SUCCESS);
+}
+
+std::vector<Brush>
+builtin_brushes(void)
+{
+    std::vector<Brush> brushes(std::size(builtins));
+
+    for (size_t i = 0; i < std::size(builtins); i++)
+        brushes[i].parse(builtins[i].name, builtins[i].cells, builtins[i].x,
+                builtins[i].y);
+
+    return (brushes);
+}
@@ -0,0 +1,82 @@
+/**
+ * BRUSH:
+ *  This file contains all prototypes and utilities needed for the brushes
+ *  cells are drawn onto the board with
+ *
+ *  A brush is a pattern kept as a bitmap, packed 64 cells to a word like
+ *  the rows of a board, with one of its cells marked as the one placed
+ *  under the cursor. Brushes come from the built-in list below or from
+ *  any pattern file, and are stamped onto the board a word at a time, so
+ *  placing one costs its size and a new brush needs no new code.
+ *
+ *  file: brush.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <bit>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#define BR_MAX_SIZE 8192            /* cells along either side of a brush */
+
+class Brush
+{
+    private:
+        std::string br_name;
+        int br_width;
+        int br_height;
+        int br_words;                   /* per row of br_bits */
+        int br_x;                       /* the cell under the cursor, */
+        int br_y;                       /* from the top-left */
+        uint64_t br_cells;              /* live cells */
+        std::vector<uint64_t> br_bits;
+
+        struct Run {
+            int64_t x;
+            int64_t y;
+            int64_t count;
+        };
+
+        int build(std::vector<Run> const&);
+        friend class RunSink;
+
+    public:
+        Brush(void);
+
+        int load(char const *);
+        int parse(char const *, char const *, int, int);
+
+        [[ nodiscard ]] std::string const& name(void) const { return this->br_name; }
+        [[ nodiscard ]] int width(void) const { return this->br_width; }
+        [[ nodiscard ]] int height(void) const { return this->br_height; }
+        [[ nodiscard ]] int words(void) const { return this->br_words; }
+        [[ nodiscard ]] int origin_x(void) const { return this->br_x; }
+        [[ nodiscard ]] int origin_y(void) const { return this->br_y; }
+        [[ nodiscard ]] uint64_t cells(void) const { return this->br_cells; }
+        [[ nodiscard ]] uint64_t const *bits(void) const { return this->br_bits.data(); }
+
+        /* calls fn(dx, dy) for every live cell, relative to the cursor */
+        template <typename F>
+        void for_each_cell(F&& fn) const
+        {
+            for (int y = 0; y < this->br_height; y++) {
+
+                uint64_t const *row = this->br_bits.data()
+                    + static_cast<size_t>(y) * this->br_words;
+
+                for (int i = 0; i < this->br_words; i++) {
+
+                    for (uint64_t word = row[i]; word; word &= word - 1)
+                        fn(i * 64 + std::countr_zero(word) - this->br_x,
+                                y - this->br_y);
+                }
+            }
+        }
+};
+
+std::vector<Brush> builtin_brushes(void);
@@ -0,0 +1,111 @@
+/**
+ * CGOL:
+ *  This file contains the simulation API
+ *
+ *  file: cgol.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+
+#include "rule.hpp"
+#include "board.hpp"
+#include "cycle.hpp"
+#include "pattern.hpp"
+#include "threadpool.hpp"
+#include "cgol.hpp"
+
+/* threads of 0 is one per core */
+Simulation::Simulation(int width, int height, Rule const& rule, int threads)
+    : sm_board(width, height)
+{
+    this->sm_board.set_pool(std::make_shared<ThreadPool>(threads));
+    this->sm_board.set_rule(rule);
+    this->sm_skip_cycles = true;
+}
+
+void
+Simulation::set_rule(Rule const& rule)
+{
+    this->sm_board.set_rule(rule);
+    this->sm_cycles.reset();
+}
+
+/*
+ * whether step() skips whole periods once the board repeats itself; the
+ * result is the same either way, but detecting cycles costs a hash of
+ * every generation
+ */
+void
+Simulation::set_skip_cycles(bool skip)
+{
+    this->sm_skip_cycles = skip;
+    this->sm_cycles.reset();
+}
+
+void
+Simulation::reset_cycles(void)
+{
+    this->sm_cycles.reset();
+}
+
+void
+Simulation::clear(void)
+{
+    this->sm_board.clear();
+    this->sm_cycles.reset();
+}
+
+/* coordinates wrap around the torus */
+void
+Simulation::set(int x, int y, bool alive)
+{
+    this->sm_board.set(x, y, alive);
+    this->sm_cycles.reset();
+}
+
+void
+Simulation::set_cells(Cell const *cells, size_t count, bool alive)
+{
+    for (size_t i = 0; i < count; i++)
+        this->sm_board.set(cells[i].x, cells[i].y, alive);
+    this->sm_cycles.reset();
+}
+
+/*
+ * brings to life, or kills, the live cells of a width x height bitmap
+ * packed (width + 63) / 64 words to a row, with its top-left at (x, y)
+ */
+void
+Simulation::stamp(int x, int y, uint64_t const *bits, int width, int height,
+        bool alive)
+{
+    this->sm_board.stamp(x, y, bits, width, height, alive);
+    this->sm_cycles.reset();
+}
+
+/*
+ * adds the cells of a pattern file, wrapped onto the board; the rule the
+ * file names, if any, is left in info for the caller to apply
+ */
+int
+Simulation::load(char const *path, PatternInfo *info)
+{
+    BoardSink sink(this->sm_board);
+
+    this->sm_cycles.reset();
+    return read_pattern(path, sink, info);
+}
+
+void
+Simulation::step(uint64_t generations)
+{
+    if (this->sm_skip_cycles)
+        advance_through_cycles(this->sm_board, this->sm_cycles, generations, false);
+    else
+        this->sm_board.advance(generations);
+}
@@ -0,0 +1,198 @@
+/**
+ * CGOL:
+ *  This file contains the simulation API the window, and anything else
+ *  that wants to run a board, is built on
+ *
+ *  A Simulation is a toroidal board with its worker threads and the
+ *  cycle detector that lets it skip through periods it has settled into.
+ *  Cells are set one at a time, from a list or from a packed bitmap, and
+ *  read back without copying: view() is the simulation's own cell words,
+ *  and live_cells() walks them, decoding live cells as it goes. Neither
+ *  outlives the next step or edit. Nothing here, or in the files it
+ *  needs, uses SDL.
+ *
+ *  file: cgol.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+
+#include "rule.hpp"
+#include "board.hpp"
+#include "cycle.hpp"
+#include "pattern.hpp"
+
+struct Cell {
+    int x;
+    int y;
+
+    bool operator==(Cell const&) const = default;
+};
+
+/* the live cells of a view in row order, found as they are walked */
+class LiveCells
+{
+    private:
+        BoardView lc_view;
+
+    public:
+        class iterator
+        {
+            private:
+                BoardView it_view;
+                int it_y;
+                int it_i;
+                uint64_t it_word;           /* live cells of word it_i not yet visited */
+
+                [[ nodiscard ]] uint64_t word(void) const
+                {
+                    uint64_t word = this->it_view.row(this->it_y)[this->it_i];
+                    int tail = this->it_view.width % 64;
+
+                    if (tail && this->it_i == this->it_view.words - 1)
+                        word &= (uint64_t{1} << tail) - 1;
+                    return (word);
+                }
+
+                /* moves on to the next word with a live cell, or the end */
+                void settle(void)
+                {
+                    while (!this->it_word && this->it_y < this->it_view.height) {
+
+                        if (++this->it_i == this->it_view.words) {
+
+                            this->it_i = 0;
+                            if (++this->it_y == this->it_view.height)
+                                break;
+                        }
+                        this->it_word = this->word();
+                    }
+                }
+
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = Cell;
+                using difference_type = std::ptrdiff_t;
+                using pointer = Cell const *;
+                using reference = Cell;
+
+                iterator(void) : it_view{}, it_y(0), it_i(0), it_word(0) {}
+
+                iterator(BoardView const& view, bool end)
+                    : it_view(view), it_y(0), it_i(0), it_word(0)
+                {
+                    if (end || view.height <= 0 || view.words <= 0) {
+
+                        this->it_y = view.height;
+                        return;
+                    }
+                    this->it_word = this->word();
+                    this->settle();
+                }
+
+                Cell operator*(void) const
+                {
+                    return {this->it_i * 64 + std::countr_zero(this->it_word), this->it_y};
+                }
+
+                iterator& operator++(void)
+                {
+                    this->it_word &= this->it_word - 1;
+                    this->settle();
+                    return (*this);
+                }
+
+                iterator operator++(int)
+                {
+                    iterator before = *this;
+
+                    ++*this;
+                    return (before);
+                }
+
+                bool operator==(iterator const& other) const
+                {
+                    return this->it_y == other.it_y && this->it_i == other.it_i
+                        && this->it_word == other.it_word;
+                }
+        };
+
+        explicit LiveCells(BoardView const& view) : lc_view(view) {}
+
+        [[ nodiscard ]] iterator begin(void) const { return iterator(this->lc_view, false); }
+        [[ nodiscard ]] iterator end(void) const { return iterator(this->lc_view, true); }
+};
+
+class Simulation
+{
+    private:
+        Board sm_board;
+        CycleDetector sm_cycles;
+        bool sm_skip_cycles;
+
+    public:
+        Simulation(int, int, Rule const& rule = R_CONWAY, int threads = 0);
+
+        Simulation(Simulation const&) = delete;
+        Simulation& operator=(Simulation const&) = delete;
+
+        [[ nodiscard ]] int width(void) const { return this->sm_board.width(); }
+        [[ nodiscard ]] int height(void) const { return this->sm_board.height(); }
+        [[ nodiscard ]] uint64_t generation(void) const { return this->sm_board.generation(); }
+        [[ nodiscard ]] Rule const& rule(void) const { return this->sm_board.rule(); }
+        [[ nodiscard ]] uint64_t population(void) const { return this->sm_board.population(); }
+
+        void set_rule(Rule const&);
+        void set_skip_cycles(bool);
+
+        void clear(void);
+        void set(int, int, bool);
+        void set_cells(Cell const *, size_t, bool alive = true);
+        void stamp(int, int, uint64_t const *, int, int, bool alive = true);
+        int load(char const *, PatternInfo * = nullptr);
+
+        void step(uint64_t generations = 1);
+
+        /*
+         * steps on by generations, calling stepped() after every one that
+         * is actually stepped; skipped periods are not
+         */
+        template <typename F>
+        void step(uint64_t generations, F&& stepped)
+        {
+            if (this->sm_skip_cycles) {
+
+                advance_through_cycles(this->sm_board, this->sm_cycles,
+                        generations, false, stepped);
+                return;
+            }
+
+            while (generations--) {
+
+                this->sm_board.step();
+                stepped();
+            }
+        }
+
+        /* the cells, valid until the next step or edit */
+        [[ nodiscard ]] BoardView view(void) const { return this->sm_board.view(); }
+        [[ nodiscard ]] LiveCells live_cells(void) const { return LiveCells(this->view()); }
+
+        /* the period of the cycle the board has settled into, 0 if none is known */
+        [[ nodiscard ]] uint64_t period(void) const { return this->sm_cycles.period(); }
+        [[ nodiscard ]] uint64_t cycle_start(void) const { return this->sm_cycles.start(); }
+
+        /*
+         * the board itself, for what is not wrapped here; anything that
+         * changes it this way has to be followed by reset_cycles()
+         */
+        [[ nodiscard ]] Board& board(void) { return this->sm_board; }
+        [[ nodiscard ]] Board const& board(void) const { return this->sm_board; }
+        void reset_cycles(void);
+};
@@ -0,0 +1,408 @@
+/**
+ * CHECKPOINT:
+ *  This file contains the binary checkpoint reader and writer
+ *
+ *  file: checkpoint.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <bit>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+    #include <io.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include "rule.hpp"
+#include "board.hpp"
+#include "mapfile.hpp"
+#include "checkpoint.hpp"
+
+Checkpoint::Checkpoint(void)
+{
+    this->cp_header = nullptr;
+}
+
+/* maps a checkpoint and checks its header, without reading any cells yet */
+int
+Checkpoint::open(char const *path)
+{
+    CheckpointHeader const *header;
+    uint64_t tiles_x;
+    uint64_t tiles_y;
+
+    this->cp_header = nullptr;
+    if (this->cp_file.open(path))
+        return (EXIT_FAILURE);
+
+    header = reinterpret_cast<CheckpointHeader const *>(this->cp_file.data());
+    if (this->cp_file.size() < sizeof(CheckpointHeader)
+            || memcmp(header->magic, CP_MAGIC, sizeof(header->magic))) {
+
+        fprintf(stderr, "[ERROR] :: %s :: %s is not a checkpoint\n", __func__,
+                path);
+        return (EXIT_FAILURE);
+    }
+
+    if (header->version != CP_VERSION || header->byte_order != CP_BYTE_ORDER) {
+
+        fprintf(stderr, "[ERROR] :: %s :: %s was written by another version or "
+                "machine\n", __func__, path);
+        return (EXIT_FAILURE);
+    }
+
+    if (!header->width || !header->height || header->width > INT_MAX
+            || header->height > INT_MAX || !header->tile_rows
+            || header->tile_rows > 64 || header->size != this->cp_file.size()
+            || (header->birth & 1) || header->birth >> 9 || header->survive >> 9)
+        goto malformed;
+
+    tiles_x = (uint64_t{header->width} + 63) / 64;
+    tiles_y = (header->height + header->tile_rows - 1) / header->tile_rows;
+    if ((tiles_x * tiles_y + 63) / 64 * sizeof(uint64_t)
+            > header->size - sizeof(CheckpointHeader))
+        goto malformed;
+
+    this->cp_header = header;
+    return (EXIT_SUCCESS);
+
+malformed:
+    fprintf(stderr, "[ERROR] :: %s :: %s is malformed\n", __func__, path);
+    return (EXIT_FAILURE);
+}
+
+/*
+ * replaces board, which must be the checkpoint's size, with its cells,
+ * rule and generation
+ */
+int
+Checkpoint::load(Board& board) const
+{
+    if (board.width() != this->width() || board.height() != this->height()) {
+
+        fprintf(stderr, "[ERROR] :: %s :: checkpoint is %dx%d, board is %dx%d\n",
+                __func__, this->width(), this->height(), board.width(),
+                board.height());
+        return (EXIT_FAILURE);
+    }
+
+    return this->load_rows(board, 0);
+}
+
+/*
+ * replaces board, which must be the checkpoint's width, with its rows
+ * from first on, wrapping past the last back to the top, and takes its
+ * rule and generation. Tiles with no row landing on board are skipped
+ * over without reading their cells
+ */
+int
+Checkpoint::load_rows(Board& board, int first) const
+{
+    CheckpointHeader const& header = *this->cp_header;
+    uint64_t const *bitmap = reinterpret_cast<uint64_t const *>(&header + 1);
+    int height = this->height();
+    int tiles_x = board.words();
+    int tiles_y = (height + header.tile_rows - 1) / header.tile_rows;
+    size_t tiles = static_cast<size_t>(tiles_x) * tiles_y;
+    uint64_t const *in = bitmap + (tiles + 63) / 64;
+    uint64_t const *end = reinterpret_cast<uint64_t const *>(
+            this->cp_file.data() + header.size);
+    uint64_t records = 0;
+
+    if (board.width() != this->width()) {
+
+        fprintf(stderr, "[ERROR] :: %s :: checkpoint is %d wide, board is %d\n",
+                __func__, this->width(), board.width());
+        return (EXIT_FAILURE);
+    }
+
+    board.clear();
+
+    for (size_t tile = 0; tile < tiles; tile++) {
+
+        if (!(bitmap[tile / 64] >> (tile % 64) & 1))
+            continue;
+        if (in >= end)
+            goto malformed;
+
+        int tx = static_cast<int>(tile % tiles_x);
+        int y0 = static_cast<int>(tile / tiles_x) * header.tile_rows;
+        int at = ((y0 - first) % height + height) % height;
+        uint64_t rows = *in++;
+        int span = static_cast<int>(std::bit_width(rows));
+
+        if (end - in < std::popcount(rows) || span > int(header.tile_rows)
+                || y0 + span > height)
+            goto malformed;
+
+        /* the tile's rows land from at on, wrapping round to row 0 */
+        if (at >= board.height() && at + span <= height) {
+
+            in += std::popcount(rows);
+            records++;
+            continue;
+        }
+        for (; rows; rows &= rows - 1) {
+
+            int r = (at + std::countr_zero(rows)) % height;
+
+            for (; r < board.height(); r += height)
+                board.set_word(tx, r, *in);
+            in++;
+        }
+        records++;
+    }
+
+    if (in != end || records != header.tiles)
+        goto malformed;
+
+    /* a malformed checkpoint leaves the board empty, but under its old rule */
+    board.set_rule(this->rule());
+    board.set_generation(header.generation);
+    return (EXIT_SUCCESS);
+
+malformed:
+    fprintf(stderr, "[ERROR] :: %s :: checkpoint is malformed\n", __func__);
+    board.clear();
+    return (EXIT_FAILURE);
+}
+
+/* flushes out through the OS onto the disk itself */
+static int
+sync_file(FILE *out)
+{
+    if (fflush(out))
+        return (EXIT_FAILURE);
+#if defined(_WIN32) || defined(__CYGWIN__)
+    return (_commit(_fileno(out))) ? EXIT_FAILURE : EXIT_SUCCESS;
+#else
+    return (fsync(fileno(out))) ? EXIT_FAILURE : EXIT_SUCCESS;
+#endif
+}
+
+/*
+ * makes a rename inside the directory holding path outlast a crash; on
+ * Windows there is no directory to sync, and NTFS journals the rename
+ */
+static int
+sync_directory(char const *path)
+{
+#if defined(_WIN32) || defined(__CYGWIN__)
+    (void) path;
+    return (EXIT_SUCCESS);
+#else
+    std::filesystem::path dir = std::filesystem::path(path).parent_path();
+    int fd = ::open((dir.empty()) ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY);
+    int rc;
+
+    if (fd < 0)
+        return (EXIT_FAILURE);
+    rc = fsync(fd);
+    close(fd);
+    return (rc) ? EXIT_FAILURE : EXIT_SUCCESS;
+#endif
+}
+
+/*
+ * opens the temporary file a checkpoint of tiles tiles is written to,
+ * leaving room at its front for the header and bitmap, which are only
+ * known once the records are written
+ */
+static FILE *
+open_checkpoint(std::string const& temp, size_t tiles)
+{
+    std::vector<uint64_t> room(sizeof(CheckpointHeader) / sizeof(uint64_t)
+            + (tiles + 63) / 64);
+    FILE *out;
+
+    if (!(out = fopen(temp.c_str(), "wb"))) {
+
+        fprintf(stderr, "[ERROR] :: %s :: cannot open %s\n", __func__,
+                temp.c_str());
+        return (nullptr);
+    }
+
+    fwrite(room.data(), sizeof(uint64_t), room.size(), out);
+    return (out);
+}
+
+/*
+ * fills in the header and bitmap of a checkpoint whose records, words
+ * words in all, are already written, syncs it and puts it in place of
+ * path, so a run killed or a machine losing power while saving leaves
+ * the previous checkpoint intact
+ */
+static int
+commit_checkpoint(FILE *out, std::string const& temp, char const *path,
+        int width, int height, Rule const& rule, uint64_t generation,
+        uint8_t const *present, uint64_t words)
+{
+    size_t tiles = static_cast<size_t>((width + 63) / 64)
+        * ((height + B_TILE_ROWS - 1) / B_TILE_ROWS);
+    std::vector<uint64_t> bitmap((tiles + 63) / 64);
+    CheckpointHeader header = {};
+    std::error_code error;
+
+    for (size_t tile = 0; tile < tiles; tile++) {
+
+        if (present[tile]) {
+
+            bitmap[tile / 64] |= uint64_t{1} << (tile % 64);
+            header.tiles++;
+        }
+    }
+
+    memcpy(header.magic, CP_MAGIC, sizeof(header.magic));
+    header.version = CP_VERSION;
+    header.byte_order = CP_BYTE_ORDER;
+    header.width = width;
+    header.height = height;
+    header.tile_rows = B_TILE_ROWS;
+    header.birth = rule.birth;
+    header.survive = rule.survive;
+    header.generation = generation;
+    header.size = sizeof(header) + (bitmap.size() + words) * sizeof(uint64_t);
+
+    fseek(out, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(bitmap.data(), sizeof(uint64_t), bitmap.size(), out);
+
+    if (ferror(out) | sync_file(out) | fclose(out)) {
+
+        fprintf(stderr, "[ERROR] :: %s :: cannot write %s\n", __func__,
+                temp.c_str());
+        remove(temp.c_str());
+        return (EXIT_FAILURE);
+    }
+
+    std::filesystem::rename(temp, path, error);
+    if (error) {
+
+        fprintf(stderr, "[ERROR] :: %s :: cannot replace %s\n", __func__, path);
+        remove(temp.c_str());
+        return (EXIT_FAILURE);
+    }
+    if (sync_directory(path)) {
+
+        fprintf(stderr, "[ERROR] :: %s :: cannot sync the directory of %s\n",
+                __func__, path);
+        return (EXIT_FAILURE);
+    }
+
+    return (EXIT_SUCCESS);
+}
+
+/*
+ * writes the records of the tiles covering count rows of board from y0,
+ * the first row of a tile of the whole board, setting present[i] for the
+ * i-th of those tiles if it has one and adding the words written to words
+ */
+int
+write_checkpoint_records(FILE *out, Board const& board, int y0, int count,
+        uint8_t *present, uint64_t *words)
+{
+    int tiles_x = board.words();
+    int tiles_y = (count + B_TILE_ROWS - 1) / B_TILE_ROWS;
+
+    for (int ty = 0; ty < tiles_y; ty++) {
+
+        int top = y0 + ty * B_TILE_ROWS;
+        int rows = std::min(B_TILE_ROWS, count - ty * B_TILE_ROWS);
+
+        for (int tx = 0; tx < tiles_x; tx++) {
+
+            uint64_t tail = (tx == tiles_x - 1) ? board.tail_mask() : ~uint64_t{0};
+            uint64_t mask = 0;
+
+            for (int r = 0; r < rows; r++) {
+
+                if (board.row(top + r)[tx] & tail)
+                    mask |= uint64_t{1} << r;
+            }
+            present[static_cast<size_t>(ty) * tiles_x + tx] = (mask != 0);
+            if (!mask)
+                continue;
+
+            fwrite(&mask, sizeof(mask), 1, out);
+            *words += 1 + std::popcount(mask);
+            for (; mask; mask &= mask - 1) {
+
+                uint64_t word = board.row(top + std::countr_zero(mask))[tx] & tail;
+                fwrite(&word, sizeof(word), 1, out);
+            }
+        }
+    }
+
+    return (ferror(out) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+/* writes board to path by way of a temporary file beside it */
+int
+write_checkpoint(char const *path, Board const& board)
+{
+    std::string temp = std::string(path) + ".tmp";
+    std::vector<uint8_t> present(static_cast<size_t>(board.tiles_x())
+            * board.tiles_y());
+    uint64_t words = 0;
+    FILE *out;
+
+    if (!(out = open_checkpoint(temp, present.size())))
+        return (EXIT_FAILURE);
+
+    write_checkpoint_records(out, board, 0, board.height(), present.data(),
+            &words);
+    return commit_checkpoint(out, temp, path, board.width(), board.height(),
+            board.rule(), board.generation(), present.data(), words);
+}
+
+/*
+ * writes a checkpoint whose records were written in pieces, in order, to
+ * parts, which are read from the start; present has a byte per tile of
+ * the whole board and words counts the words in all the parts
+ */
+int
+write_checkpoint_parts(char const *path, int width, int height,
+        Rule const& rule, uint64_t generation, uint8_t const *present,
+        std::vector<FILE *> const& parts, uint64_t words)
+{
+    std::string temp = std::string(path) + ".tmp";
+    size_t tiles = static_cast<size_t>((width + 63) / 64)
+        * ((height + B_TILE_ROWS - 1) / B_TILE_ROWS);
+    char buf[1 << 16];
+    size_t n;
+    FILE *out;
+
+    if (!(out = open_checkpoint(temp, tiles)))
+        return (EXIT_FAILURE);
+
+    for (FILE *part : parts) {
+
+        rewind(part);
+        while ((n = fread(buf, 1, sizeof(buf), part)))
+            fwrite(buf, 1, n, out);
+        if (ferror(part)) {
+
+            fprintf(stderr, "[ERROR] :: %s :: cannot read back a part of %s\n",
+                    __func__, path);
+            fclose(out);
+            remove(temp.c_str());
+            return (EXIT_FAILURE);
+        }
+    }
+
+    return commit_checkpoint(out, temp, path, width, height, rule, generation,
+            present, words);
+}
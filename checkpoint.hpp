@@ -0,0 +1,87 @@
+/**
+ * CHECKPOINT:
+ *  This file contains all prototypes and utilities needed to save a dense
+ *  board to a binary checkpoint and to load it back
+ *
+ *  A checkpoint is a CheckpointHeader, then a bitmap with one bit per
+ *  tile that has any live cell, then a record for each of those tiles in
+ *  row-major tile order: a word with a bit set for every one of the
+ *  tile's rows that is not empty, followed by those rows' words. Empty
+ *  tiles take one bit, and empty rows in a busy tile nothing. Everything
+ *  is a 64-bit word in the byte order of the machine that wrote it, so a
+ *  file mapped into memory is read in place with no parsing.
+ *
+ *  file: checkpoint.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+#include "rule.hpp"
+#include "board.hpp"
+#include "mapfile.hpp"
+
+#define CP_MAGIC "CGOLCKPT"
+#define CP_VERSION 1
+#define CP_BYTE_ORDER 0x01020304u
+
+struct CheckpointHeader {
+    char magic[8];              /* CP_MAGIC, without its terminator */
+    uint32_t version;
+    uint32_t byte_order;        /* CP_BYTE_ORDER as the writer stored it */
+    uint32_t width;
+    uint32_t height;
+    uint32_t tile_rows;         /* B_TILE_ROWS of the writer */
+    uint16_t birth;
+    uint16_t survive;
+    uint64_t generation;
+    uint64_t tiles;             /* tiles with a record */
+    uint64_t size;              /* bytes in the whole file */
+    uint64_t reserved;
+};
+
+static_assert(sizeof(CheckpointHeader) == 64);
+
+class Checkpoint
+{
+    private:
+        MappedFile cp_file;
+        CheckpointHeader const *cp_header;
+
+    public:
+        Checkpoint(void);
+
+        int open(char const *);
+        int load(Board&) const;
+        int load_rows(Board&, int) const;
+
+        [[ nodiscard ]] int width(void) const { return this->cp_header->width; }
+        [[ nodiscard ]] int height(void) const { return this->cp_header->height; }
+
+        [[ nodiscard ]] uint64_t generation(void) const
+        {
+            return this->cp_header->generation;
+        }
+
+        [[ nodiscard ]] Rule rule(void) const
+        {
+            return {this->cp_header->birth, this->cp_header->survive};
+        }
+};
+
+int write_checkpoint(char const *, Board const&);
+
+/*
+ * the same in pieces, for a board no one process holds: each piece writes
+ * the records of a band of whole tiles, and the pieces are then put
+ * together in order under one header
+ */
+int write_checkpoint_records(FILE *, Board const&, int, int, uint8_t *, uint64_t *);
+int write_checkpoint_parts(char const *, int, int, Rule const&, uint64_t,
+        uint8_t const *, std::vector<FILE *> const&, uint64_t);
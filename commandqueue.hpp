@@ -0,0 +1,57 @@
+/**
+ * COMMANDQUEUE:
+ *  This file contains the lock-free single-producer, single-consumer ring
+ *  used to pass edits from the render thread to the simulation thread
+ *
+ *  file: commandqueue.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+template <typename T, size_t N>
+class CommandQueue
+{
+    static_assert((N & (N - 1)) == 0, "CommandQueue size must be a power of two");
+
+    private:
+        T q_ring[N];
+        alignas(64) std::atomic<size_t> q_head;     /* next slot to pop */
+        alignas(64) std::atomic<size_t> q_tail;     /* next slot to push */
+
+    public:
+        CommandQueue(void) : q_head(0), q_tail(0) {}
+
+        CommandQueue(CommandQueue const&) = delete;
+        CommandQueue& operator=(CommandQueue const&) = delete;
+
+        /* producer only; false when the ring is full */
+        bool push(T const& item)
+        {
+            size_t tail = this->q_tail.load(std::memory_order_relaxed);
+
+            if (tail - this->q_head.load(std::memory_order_acquire) == N)
+                return (false);
+
+            this->q_ring[tail & (N - 1)] = item;
+            this->q_tail.store(tail + 1, std::memory_order_release);
+            return (true);
+        }
+
+        /* consumer only; false when the ring is empty */
+        bool pop(T *item)
+        {
+            size_t head = this->q_head.load(std::memory_order_relaxed);
+
+            if (head == this->q_tail.load(std::memory_order_acquire))
+                return (false);
+
+            *item = this->q_ring[head & (N - 1)];
+            this->q_head.store(head + 1, std::memory_order_release);
+            return (true);
+        }
+};
@@ -0,0 +1,93 @@
+/**
+ * CYCLE:
+ *  This file contains the cycle detector for settled boards
+ *
+ *  file: cycle.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <unordered_map>
+
+#include "cycle.hpp"
+
+CycleDetector::CycleDetector(size_t history)
+{
+    this->c_hashes = std::vector<uint64_t>(std::max<size_t>(history, 1));
+    this->reset();
+}
+
+/* forgets every generation seen, as after an edit to the board */
+void
+CycleDetector::reset(void)
+{
+    this->c_seen.clear();
+    this->c_first = 0;
+    this->c_next = 0;
+    this->c_period = 0;
+    this->c_start = 0;
+}
+
+/*
+ * records the hash of the board at generation, and returns the period of
+ * the cycle the board is in, or 0 while none has been found. Generations
+ * are expected one after another, though the last one may be given again;
+ * a gap, or going back, starts over. Edits to the board need a reset()
+ */
+uint64_t
+CycleDetector::observe(uint64_t generation, uint64_t hash)
+{
+    size_t size = this->c_hashes.size();
+
+    if (!this->c_seen.empty() && generation + 1 == this->c_next)
+        return (this->c_period);
+
+    if (this->c_seen.empty() || generation != this->c_next) {
+
+        this->reset();
+        this->c_first = generation;
+    }
+    this->c_next = generation + 1;
+
+    if (this->c_period)
+        return (this->c_period);
+
+    auto seen = this->c_seen.find(hash);
+    if (seen != this->c_seen.end()) {
+
+        this->c_start = seen->second;
+        this->c_period = generation - seen->second;
+        return (this->c_period);
+    }
+
+    if (generation - this->c_first == size) {
+
+        uint64_t oldest = this->c_hashes[this->c_first % size];
+        auto entry = this->c_seen.find(oldest);
+
+        if (entry != this->c_seen.end() && entry->second == this->c_first)
+            this->c_seen.erase(entry);
+        this->c_first++;
+    }
+    this->c_hashes[generation % size] = hash;
+    this->c_seen[hash] = generation;
+
+    return (0);
+}
+
+/*
+ * takes the board to be at generation, stepped or skipped there within
+ * the cycle already found, so the next observe() keeps the period instead
+ * of seeing a gap; without a period there is nothing to keep
+ */
+void
+CycleDetector::advance_to(uint64_t generation)
+{
+    if (this->c_period)
+        this->c_next = generation + 1;
+}
+
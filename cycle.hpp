@@ -0,0 +1,97 @@
+/**
+ * CYCLE:
+ *  This file contains all prototypes and utilities needed to notice when a
+ *  board has settled into a cycle
+ *
+ *  The detector is fed the board's hash after every generation and keeps
+ *  the last few thousand in a ring, indexed by hash. The first time a hash
+ *  comes back, the board is taken to repeat with the distance between the
+ *  two as its period; from then on any multiple of the period can be
+ *  skipped without stepping. Cycles longer than the history go unnoticed.
+ *
+ *  file: cycle.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+
+#include "board.hpp"
+
+#define C_DEFAULT_HISTORY 4096      /* generations remembered */
+
+class CycleDetector
+{
+    private:
+        std::vector<uint64_t> c_hashes;                 /* ring, by generation */
+        std::unordered_map<uint64_t, uint64_t> c_seen;  /* hash to latest generation */
+        uint64_t c_first;           /* oldest generation still in the ring */
+        uint64_t c_next;            /* generation expected next */
+        uint64_t c_period;          /* 0 until a cycle is found */
+        uint64_t c_start;           /* first generation of the cycle */
+
+    public:
+        explicit CycleDetector(size_t history = C_DEFAULT_HISTORY);
+
+        void reset(void);
+        uint64_t observe(uint64_t, uint64_t);
+        void advance_to(uint64_t);
+
+        [[ nodiscard ]] uint64_t period(void) const { return this->c_period; }
+        [[ nodiscard ]] uint64_t start(void) const { return this->c_start; }
+};
+
+/*
+ * steps board on by generations, feeding every one to cycles and then
+ * calling stepped(). Once the board is known to cycle, whole periods are
+ * skipped and only the rest is stepped; with stop set, the board is left
+ * where the cycle was noticed
+ */
+template <typename F>
+void
+advance_through_cycles(Board& board, CycleDetector& cycles,
+        uint64_t generations, bool stop, F&& stepped)
+{
+    uint64_t target = board.generation() + generations;
+
+    board.track_hash();
+    cycles.observe(board.generation(), board.hash());
+    while (board.generation() < target) {
+
+        if (uint64_t period = cycles.period()) {
+
+            if (stop)
+                return;
+
+            uint64_t left = target - board.generation();
+
+            /* skipped generations are never seen, only the one landed on */
+            board.fast_forward(left - left % period);
+            if (left >= period)
+                stepped();
+            for (left %= period; left; left--) {
+
+                board.step();
+                stepped();
+            }
+            cycles.advance_to(board.generation());
+            return;
+        }
+
+        board.step();
+        cycles.observe(board.generation(), board.hash());
+        stepped();
+    }
+}
+
+inline void
+advance_through_cycles(Board& board, CycleDetector& cycles,
+        uint64_t generations, bool stop)
+{
+    advance_through_cycles(board, cycles, generations, stop, []() {});
+}
@@ -7,8 +7,14 @@
  *  year: 2022
  */
 
+#include <bit>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <utility>
 #include <cstdio>
 #include <cstdint>
+#include <cstring>
 #include <algorithm>
 
 #if defined(__gnu_linux__) || defined(__linux__)
@@ -20,31 +26,68 @@
 #endif
 
 #include "game.hpp"
+#include "cgol.hpp"
+#include "board.hpp"
+#include "brush.hpp"
+#include "cycle.hpp"
+#include "history.hpp"
+#include "checkpoint.hpp"
+#include "profile.hpp"
+#include "rule.hpp"
+#include "pattern.hpp"
+#include "pyramid.hpp"
+#include "scheduler.hpp"
 #include "window.hpp"
 #include "renderer.hpp"
 
-Game::Game(void)
+/*
+ * a zoom of 0 scales the board to fit a G_WINDOW_SIZE window, in whole
+ * pixels per cell if it is small enough, and below one pixel if not
+ */
+Game::Game(int width, int height, double zoom, int threads)
+    : g_sim(width, height, R_CONWAY, threads)
 {
     this->g_window = std::make_shared<Window>(nullptr);
     this->g_renderer = std::make_shared<Renderer>(nullptr);
-    this->g_board = std::vector<uint8_t>(G_BOARD_SIZE * G_BOARD_SIZE);
-    this->g_next_iteration = std::vector<uint8_t>(G_BOARD_SIZE * G_BOARD_SIZE);
+    this->g_fit_zoom = (std::max(width, height) <= G_WINDOW_SIZE)
+        ? G_WINDOW_SIZE / std::max(width, height)
+        : static_cast<double>(G_WINDOW_SIZE) / std::max(width, height);
+    this->g_level = 0;
+    this->g_region = {0, 0, 0, 0};
+    this->g_src = {0, 0, 0, 0};
+    this->g_dst = {0, 0, 0, 0};
+    this->reset_view();
+    if (zoom > 0)
+        this->g_zoom = std::min(zoom, G_MAX_ZOOM);
     this->g_state = G_RUNNING;
+    this->g_brushes = builtin_brushes();
     this->g_brush = 0;
+    this->g_sim_running = false;
     this->g_paused = false;
+    this->g_sim_wakes = 0;
+    this->g_rate = G_DEFAULT_RATE;
+    this->g_last_rate = G_DEFAULT_RATE;
+    this->g_checkpoint_path = G_DEFAULT_CHECKPOINT;
+    this->g_births = 0;
+    this->g_deaths = 0;
+    this->g_frame = {};
 }
 
 Game::~Game()
 {
     this->g_renderer.reset();   /* destroys renderer? */
     this->g_window.reset();     /* destroys window? */
-    this->g_board.clear();
+    this->g_sim.clear();
     SDL_Quit();
 }
 
 int
-Game::init(int unsigned window_width, int unsigned window_height)
+Game::init(void)
 {
+    int window_width = std::clamp(static_cast<int>(std::ceil(
+                    this->g_sim.width() * this->g_zoom)), 1, G_MAX_WINDOW_SIZE);
+    int window_height = std::clamp(static_cast<int>(std::ceil(
+                    this->g_sim.height() * this->g_zoom)), 1, G_MAX_WINDOW_SIZE);
     int rc;
 
     if (rc = SDL_Init(SDL_INIT_EVERYTHING), rc) {
@@ -75,71 +118,149 @@ out:
     return (rc);
 }
 
+/* the scroll wheel doubles or halves the rate, within 1..G_MAX_RATE */
 int
-calculate_circular_index(int a)
+rate_bounds_check(int rate, int delta)
 {
-    int mod = a % G_BOARD_SIZE;
-    return (mod < 0) ? (mod + G_BOARD_SIZE) : (mod);
+    if (delta > 0)
+        rate = (rate > G_MAX_RATE / 2) ? G_MAX_RATE : rate * 2;
+    else if (delta < 0)
+        rate /= 2;
+
+    return std::clamp(rate, 1, G_MAX_RATE);
 }
 
-int
-framerate_bounds_check(int frame_delim, int delta)
+/* generations per second, or S_UNLIMITED to run as fast as possible */
+void
+Game::set_rate(int rate)
 {
-    frame_delim += delta;
+    this->g_rate = std::clamp(rate, S_UNLIMITED, G_MAX_RATE);
+    if (rate != S_UNLIMITED)
+        this->g_last_rate = this->g_rate;
+}
 
-    if (frame_delim > 60)
-        frame_delim = 60;
-    if (frame_delim < 1)
-        frame_delim = 1;
+/* only blocks if the sim thread has fallen a whole queue behind */
+void
+Game::push_command(Command const& cmd)
+{
+    while (!this->g_commands.push(cmd))
+        std::this_thread::yield();
+    this->wake_sim();
+}
 
-    return (frame_delim);
+/* ends the wait of a paused sim thread, to take commands or to carry on */
+void
+Game::wake_sim(void)
+{
+    this->g_sim_wakes.fetch_add(1, std::memory_order_release);
+    this->g_sim_wakes.notify_one();
 }
 
 void
-Game::set_cell(int x, int y, uint8_t val)
+Game::apply_command(Command const& cmd)
 {
-    int b_x = (x < 0 || x >= G_BOARD_SIZE) ? calculate_circular_index(x) : x;
-    int b_y = (y < 0 || y >= G_BOARD_SIZE) ? calculate_circular_index(y) : y;
+    switch (cmd.type) {
+        case Command::G_STAMP: {
+            Brush const& brush = this->g_brushes[cmd.brush];
 
-    if (this->g_board[b_x + b_y * G_BOARD_SIZE] != val) {
-        this->g_board[b_x + b_y * G_BOARD_SIZE] = val;
-    }
+            this->g_sim.stamp(cmd.x - brush.origin_x(), cmd.y - brush.origin_y(),
+                    brush.bits(), brush.width(), brush.height(), cmd.value);
+            break;
+        }
+        case Command::G_CLEAR: {
+            /* kept, so history takes the clear as an edit rather than a restart */
+            uint64_t generation = this->g_sim.generation();
 
-    if (val)
-        this->remember_cell(b_x, b_y);
-    else
-        this->forget_cell(b_x, b_y);
+            this->g_sim.clear();
+            this->g_sim.board().set_generation(generation);
+            break;
+        }
+        case Command::G_SEEK:
+            this->seek(cmd.x);
+            break;
+        case Command::G_SAVE:
+            if (!write_checkpoint(this->g_checkpoint_path.c_str(), this->g_sim.board()))
+                fprintf(stderr, "[INFO] :: %s :: saved generation %llu to %s\n",
+                        __func__, static_cast<unsigned long long>(
+                            this->g_sim.generation()),
+                        this->g_checkpoint_path.c_str());
+            break;
+    }
 }
 
-uint8_t
-Game::get_cell(int x, int y) const
+/* adds the board as it is now to the history; sim thread only */
+void
+Game::record(void)
 {
-    int b_x = (x < 0 || x >= G_BOARD_SIZE) ? calculate_circular_index(x) : x;
-    int b_y = (y < 0 || y >= G_BOARD_SIZE) ? calculate_circular_index(y) : y;
+    ProfileScope scope(this->g_profiler, PF_HISTORY);
 
-    return this->g_board[b_x + b_y * G_BOARD_SIZE];
+    this->g_history.record(this->g_sim.board());
 }
 
-int
-Game::calculate_neighbour_count(int x, int y) const
+/*
+ * after every generation stepped: counts the cells it changed while
+ * profiling, and records it; sim thread only
+ */
+void
+Game::stepped(void)
 {
-    int neighbour_count = 0;
+    if (this->g_profiler.enabled())
+        this->g_sim.board().count_changes(&this->g_births, &this->g_deaths);
+    this->record();
+}
+
+/*
+ * moves the board offset generations from where it is: back through the
+ * history, no further than its oldest generation, or forwards through it
+ * and then on by stepping; sim thread only
+ */
+void
+Game::seek(int offset)
+{
+    uint64_t generation = this->g_sim.generation();
+    uint64_t target;
+
+    if (this->g_history.empty()) {
+
+        if (offset > 0)
+            this->g_sim.step(offset);
+        return;
+    }
+
+    if (offset < 0) {
 
-    neighbour_count += this->get_cell(x - 1, y - 1);
-    neighbour_count += this->get_cell(x, y - 1);
-    neighbour_count += this->get_cell(x + 1, y - 1);
-    neighbour_count += this->get_cell(x - 1, y);
-    neighbour_count += this->get_cell(x + 1, y);
-    neighbour_count += this->get_cell(x - 1, y + 1);
-    neighbour_count += this->get_cell(x, y + 1);
-    neighbour_count += this->get_cell(x + 1, y + 1);
+        uint64_t back = static_cast<uint64_t>(-static_cast<int64_t>(offset));
+        target = (generation - this->g_history.oldest() < back)
+            ? this->g_history.oldest() : generation - back;
+    } else {
 
-    return (neighbour_count);
+        target = generation + offset;
+    }
+
+    if (target <= this->g_history.newest()) {
+
+        this->g_history.seek(target, this->g_sim.board());
+        return;
+    }
+
+    if (generation < this->g_history.newest())
+        this->g_history.seek(this->g_history.newest(), this->g_sim.board());
+    this->g_sim.step(target - this->g_sim.generation(), [this]() {
+        this->stepped();
+    });
+}
+
+/* places (val 1) or erases the current brush with the cursor on cell (x, y) */
+void
+Game::stamp(int x, int y, uint8_t val)
+{
+    this->push_command({Command::G_STAMP, val, x, y, this->g_brush});
 }
 
 void
 Game::handle_mouse(void)
 {
+    ProfileScope scope(this->g_profiler, PF_MOUSE);
     int         m_x;
     int         m_y;
     uint32_t    m_btns;
@@ -150,362 +271,690 @@ Game::handle_mouse(void)
         int b_x;
         int b_y;
 
-        /* round value to the nearest multiple of 10 */
-        b_x = m_x / 10;
-        b_y = m_y / 10;
+        /* round down to the cell under the cursor */
+        b_x = static_cast<int>(std::floor(this->g_view_x + m_x / this->g_zoom));
+        b_y = static_cast<int>(std::floor(this->g_view_y + m_y / this->g_zoom));
 
-        (this->*(this->g_brush_selections[this->g_brush]))(b_x, b_y);
+        this->highlight_brush(b_x, b_y);
 
         if (m_btns & SDL_BUTTON_LMASK)
-            (this->*(this->g_brush_placements[this->g_brush]))(b_x, b_y, 1);
+            this->stamp(b_x, b_y, 1);
         else if (m_btns & SDL_BUTTON_RMASK)
-            (this->*(this->g_brush_placements[this->g_brush]))(b_x, b_y, 0);
+            this->stamp(b_x, b_y, 0);
     }
 }
 
 void
-Game::handle_keyboard(SDL_Event *event, int *frame_delim)
+Game::handle_event(SDL_Event *event)
 {
-    while (SDL_PollEvent(event)) {
+    switch (event->type) {
 
-        switch (event->type) {
-
-            case SDL_QUIT:
-                this->g_state = G_STOPPED;
-                break;
-            case SDL_KEYDOWN:
-                switch (event->key.keysym.sym) {
-
-                    case SDLK_p:
-                        this->g_paused = !this->g_paused;
-                        break;
-                    case SDLK_c:
-                        this->clear_board();
-                        break;
-                    case SDLK_RIGHT:
-                        this->next_brush(1);
-                        break;
-                    case SDLK_LEFT:
-                        this->next_brush(-1);
+        case SDL_QUIT:
+            this->g_state = G_STOPPED;
+            break;
+        case SDL_KEYDOWN:
+            switch (event->key.keysym.sym) {
+
+                case SDLK_p:
+                    this->g_paused = !this->g_paused.load();
+                    this->wake_sim();
+                    break;
+                case SDLK_c:
+                    this->clear_board();
+                    break;
+                case SDLK_f:
+                    this->set_rate((this->g_rate == S_UNLIMITED)
+                            ? this->g_last_rate : S_UNLIMITED);
+                    break;
+                case SDLK_RIGHT:
+                    this->next_brush(1);
+                    break;
+                case SDLK_LEFT:
+                    this->next_brush(-1);
+                    break;
+                case SDLK_EQUALS:
+                case SDLK_MINUS: {
+                    int width;
+                    int height;
+
+                    if (this->renderer()->output_size(&width, &height))
                         break;
+                    this->zoom_at((event->key.keysym.sym == SDLK_EQUALS)
+                            ? G_ZOOM_STEP : 1 / G_ZOOM_STEP, width / 2, height / 2);
+                    break;
                 }
+                case SDLK_0:
+                    this->reset_view();
+                    break;
+                case SDLK_k:
+                    this->push_command({Command::G_SAVE, 0, 0, 0});
+                    break;
+                case SDLK_o:
+                    this->g_profiler.set_overlay(!this->g_profiler.overlay());
+                    break;
+                case SDLK_COMMA:
+                case SDLK_PERIOD: {
+                    int step = (SDL_GetModState() & KMOD_SHIFT) ? G_SEEK_STEP : 1;
+
+                    this->g_paused = true;
+                    this->push_command({Command::G_SEEK, 0,
+                            (event->key.keysym.sym == SDLK_COMMA) ? -step : step, 0});
+                    break;
+                }
+            }
+            break;
+        case SDL_MOUSEMOTION:
+            if (event->motion.state & SDL_BUTTON_MMASK)
+                this->pan(event->motion.xrel, event->motion.yrel);
+            break;
+        case SDL_MOUSEWHEEL:
+            if (SDL_GetModState() & KMOD_CTRL) {
+
+                int m_x;
+                int m_y;
+
+                SDL_GetMouseState(&m_x, &m_y);
+                if (event->wheel.y)
+                    this->zoom_at((event->wheel.y > 0) ? G_ZOOM_STEP
+                            : 1 / G_ZOOM_STEP, m_x, m_y);
                 break;
-            case SDL_MOUSEWHEEL:
-                if (event->wheel.y > 0)
-                    *frame_delim = framerate_bounds_check(*frame_delim, 1);
-                else if (event->wheel.y < 0)
-                    *frame_delim = framerate_bounds_check(*frame_delim, -1);
+            }
+            if (this->g_rate == S_UNLIMITED)
                 break;
-        }
-    }
-}
-
-void
-Game::clear_board(void)
-{
-    std::vector<uint8_t>::iterator iter;
-    for (iter = this->g_board.begin(); iter != this->g_board.end(); iter++) {
-
-        *iter = 0;
+            if (event->wheel.y > 0)
+                this->set_rate(rate_bounds_check(this->g_rate, 1));
+            else if (event->wheel.y < 0)
+                this->set_rate(rate_bounds_check(this->g_rate, -1));
+            break;
     }
-    this->g_alive_cells.clear();
 }
 
 void
-Game::next_iteration(void)
+Game::handle_keyboard(SDL_Event *event)
 {
-    for (int y = 0; y < G_BOARD_SIZE; y++) {
+    ProfileScope scope(this->g_profiler, PF_EVENTS);
 
-        for (int x = 0; x < G_BOARD_SIZE; x++) {
-
-            int neighbour_count = this->calculate_neighbour_count(x, y);
-            uint8_t current_cell = this->get_cell(x, y);
-
-            this->g_next_iteration[x + y * G_BOARD_SIZE] = current_cell;
-            // at any given point in the simulation, it is more likely that 
-            // there will be more dead cells than alive cells on the board
-            if (current_cell) [[unlikely]] {
-
-                if (neighbour_count < 2 || neighbour_count > 3) {
-                    this->g_next_iteration[x + y * G_BOARD_SIZE] = 0;
-                    this->forget_cell(x, y);
-                }
-            } else [[likely]] {
-
-                if (neighbour_count == 3) {
-                    this->g_next_iteration[x + y * G_BOARD_SIZE] = 1;
-                    this->remember_cell(x, y);
-                }
-            }
-        }
-    }
-
-    std::swap(this->g_board, this->g_next_iteration);
+    while (SDL_PollEvent(event))
+        this->handle_event(event);
 }
 
 void
-Game::display_board(void)
+Game::clear_board(void)
 {
-    for (auto& [x, y] : this->g_alive_cells) {
-
-        this->renderer()->draw_filled_box(x * 10, y * 10, 255, 255, 255, 255);
-    }
+    this->push_command({Command::G_CLEAR, 0, 0, 0});
 }
 
-void
-Game::loop(void)
+/*
+ * replaces the board with a pattern file, wrapped onto the torus, and
+ * adopts the rule the file names; must be called before loop() starts the
+ * sim thread
+ */
+int
+Game::load_pattern(char const *path)
 {
-    SDL_Event       event;
-    int unsigned    previous_tick = 0;
-    int unsigned    current_tick;
-    int             frame_delim = 5;
-    int             err;
-
-    while (this->g_state == G_RUNNING) {
-
-        if (err = SDL_ShowCursor(SDL_DISABLE), err < 0)
-            this->g_state = G_STOPPED;
-
-        current_tick = SDL_GetTicks();
-        this->g_renderer->clear();
-        this->handle_keyboard(&event, &frame_delim);
+    PatternInfo info;
+    Rule rule;
 
-        if (!this->g_paused) {
+    this->g_sim.clear();
+    if (this->g_sim.load(path, &info))
+        return (EXIT_FAILURE);
 
-            if ((current_tick - previous_tick) > 1000 / frame_delim) {
+    if (!info.rule.empty()) {
 
-                this->next_iteration();
-                previous_tick = current_tick;
-            }
-        }
-        this->display_board();
-        this->handle_mouse();
-        this->g_renderer->present();
+        if (parse_rule(info.rule.c_str(), &rule))
+            return (EXIT_FAILURE);
+        this->g_sim.set_rule(rule);
     }
+    return (EXIT_SUCCESS);
 }
 
-void
-Game::next_brush(int delta)
+/*
+ * adds a pattern file to the brushes the arrow keys pick from; must be
+ * called before loop() starts the sim thread
+ */
+int
+Game::add_brush(char const *path)
 {
-    int size = static_cast<int>(this->g_brush_selections.size());
-    this->g_brush += delta;
-    if (this->g_brush >= size)
-        this->g_brush = 0;
-    if (this->g_brush < 0)
-        this->g_brush = size - 1;
-}
+    Brush brush;
 
-void
-Game::remember_cell(int x, int y)
-{
-    for (const auto& [x_alive, y_alive]: this->g_alive_cells) {
+    if (brush.load(path))
+        return (EXIT_FAILURE);
 
-        if (x == x_alive && y == y_alive)
-            return;
-    }
-    std::pair<int, int> cell_memory = {x, y};
-    this->g_alive_cells.emplace_back(cell_memory);
+    this->g_brushes.push_back(std::move(brush));
+    return (EXIT_SUCCESS);
 }
 
-void
-Game::forget_cell(int x, int y)
+/*
+ * replaces the board with a checkpoint of the same size, taking its rule
+ * and generation; must be called before loop() starts the sim thread
+ */
+int
+Game::load_checkpoint(Checkpoint const& checkpoint)
 {
-    std::pair<int, int> cell_memory = {x, y};
-    this->g_alive_cells.erase(std::remove(this->g_alive_cells.begin(),
-                this->g_alive_cells.end(), cell_memory),
-            this->g_alive_cells.end());
+    return checkpoint.load(this->g_sim.board());
 }
 
+/* where the k key saves checkpoints */
 void
-Game::select_cell(int x, int y)
+Game::set_checkpoint_path(char const *path)
 {
-    this->renderer()->draw_selection_box(x * 10, y * 10, 255, 0, 0, 255);
+    this->g_checkpoint_path = path;
 }
 
+/*
+ * keeps a trace of every frame and the generations behind it, written to
+ * path when the window closes; before loop() starts the sim thread
+ */
 void
-Game::select_block(int x, int y)
+Game::set_trace(char const *path)
 {
-    this->renderer()->draw_selection_box(x * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 1) * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, (y + 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 1) * 10, (y + 1) * 10, 255, 0, 0, 255);
+    this->g_trace_path = path;
+    this->g_profiler.set_tracing(true);
 }
 
+/* must be called before loop() starts the sim thread */
 void
-Game::select_beehive(int x, int y)
+Game::set_rule(Rule const& rule)
 {
-    this->renderer()->draw_selection_box((x - 1) * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, (y - 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, (y + 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 1) * 10, (y - 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 1) * 10, (y + 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 2) * 10, y * 10, 255, 0, 0, 255);
+    this->g_sim.set_rule(rule);
 }
 
+/*
+ * how many bytes of past generations to keep for rewinding, 0 for none,
+ * and how many generations apart the full copies are; must be called
+ * before loop() starts the sim thread
+ */
 void
-Game::select_loaf(int x, int y)
+Game::set_history(size_t bytes, int interval)
 {
-    this->renderer()->draw_selection_box((x - 1) * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, (y - 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, (y + 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 1) * 10, (y - 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 1) * 10, (y + 2) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 2) * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 2) * 10, (y + 1) * 10, 255, 0, 0, 255);
+    this->g_history.configure(bytes, interval);
 }
 
+/*
+ * copies the board into the back snapshot and hands it to the render
+ * thread, along with the sim thread's share of the profile since the last
+ * one. The population is counted off each row while it is still in cache
+ */
 void
-Game::select_boat(int x, int y)
+Game::publish_snapshot(void)
 {
-    this->renderer()->draw_selection_box((x - 1) * 10, (y - 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x - 1) * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, (y - 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, (y + 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 1) * 10, y * 10, 255, 0, 0, 255);
-}
+    ProfileScope scope(this->g_profiler, PF_PUBLISH);
+    Snapshot& snap = this->g_snapshots.back();
+    Board& board = this->g_sim.board();
+    int words = board.words();
 
-void
-Game::select_tub(int x, int y)
-{
-    this->renderer()->draw_selection_box((x - 1) * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, (y - 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, (y + 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 1) * 10, y * 10, 255, 0, 0, 255);
-}
+    snap.stats = {};
+    snap.cells.resize(static_cast<size_t>(words) * board.height());
+    for (int y = 0; y < board.height(); y++) {
 
-void
-Game::select_blinker(int x, int y)
-{
-    this->renderer()->draw_selection_box(x * 10, (y - 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, (y + 1) * 10, 255, 0, 0, 255);
-}
+        uint64_t *row = snap.cells.data() + static_cast<size_t>(y) * words;
 
-void
-Game::select_toad(int x, int y)
-{
-    this->renderer()->draw_selection_box((x - 1) * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, (y - 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 1) * 10, (y - 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 1) * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 2) * 10, (y - 1) * 10, 255, 0, 0, 255);
-}
+        memcpy(row, board.row(y), words * sizeof(uint64_t));
+        for (int i = 0; i < words; i++)
+            snap.stats.population += std::popcount(row[i]);
+    }
 
+    snap.view = {snap.cells.data(), static_cast<size_t>(words),
+        board.width(), board.height(), words};
+
+    /* every snapshot is consumed, so the dirty tiles add up to all changes */
+    snap.dirty.assign(board.dirty_tiles(), board.dirty_tiles()
+            + static_cast<size_t>(board.tiles_x()) * board.tiles_y());
+    board.clear_dirty();
+    snap.generation = board.generation();
+
+    for (int z = PF_STEP; z < PF_ZONES; z++)
+        snap.stats.seconds[z] = this->g_profiler.take(static_cast<ProfileZone>(z));
+    snap.stats.generation = snap.generation;
+    snap.stats.births = this->g_births;
+    snap.stats.deaths = this->g_deaths;
+    this->g_births = 0;
+    this->g_deaths = 0;
+
+    this->g_snapshots.publish();
+}
+
+/*
+ * the sim thread owns the board: it applies queued edits, runs whatever
+ * batch of generations the scheduler says is due, and publishes a snapshot
+ * whenever the board has changed and the render thread has taken the
+ * previous one. Once the board settles into a cycle it is reported, and
+ * whole periods are skipped instead of stepped until the next edit. Every
+ * generation stepped and every edit goes into the history
+ */
 void
-Game::select_beacon(int x, int y)
+Game::simulate(void)
 {
-    this->renderer()->draw_selection_box((x - 1) * 10, (y - 2) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x - 1) * 10, (y - 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, (y - 2) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 1) * 10, (y + 1) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 2) * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 2) * 10, (y + 1) * 10, 255, 0, 0, 255);
+    Scheduler   scheduler(this->g_rate, G_FRAME_BUDGET);
+    bool        dirty = true;
+    Command     cmd;
+
+    this->record();
+    while (this->g_sim_running.load(std::memory_order_acquire)) {
+
+        uint64_t generations = 0;
+        bool edited = false;
+        uint32_t wakes = this->g_sim_wakes.load(std::memory_order_acquire);
+
+        while (this->g_commands.pop(&cmd)) {
+
+            /* edits are recorded before seeking away from them */
+            if (cmd.type == Command::G_SEEK && edited) {
+
+                this->record();
+                edited = false;
+            }
+            this->apply_command(cmd);
+            this->g_sim.reset_cycles();
+            edited |= cmd.type == Command::G_STAMP
+                || cmd.type == Command::G_CLEAR;
+            dirty = true;
+        }
+        if (edited)
+            this->record();
+
+        if (scheduler.rate() != this->g_rate)
+            scheduler.set_rate(this->g_rate);
+
+        if (this->g_paused) {
+
+            scheduler.reset();
+        } else if ((generations = scheduler.due())) {
+
+            uint64_t period = this->g_sim.period();
+            auto start = std::chrono::steady_clock::now();
+            {
+                ProfileScope scope(this->g_profiler, PF_STEP);
+
+                this->g_sim.step(generations, [this]() { this->stepped(); });
+            }
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+
+            scheduler.ran(generations, elapsed.count());
+            dirty = true;
+
+            if (!period && this->g_sim.period())
+                fprintf(stderr, "[INFO] :: %s :: period %llu cycle since "
+                        "generation %llu\n", __func__,
+                        static_cast<unsigned long long>(this->g_sim.period()),
+                        static_cast<unsigned long long>(this->g_sim.cycle_start()));
+        }
+
+        if (dirty && this->g_snapshots.consumed()) {
+
+            this->publish_snapshot();
+            dirty = false;
+        }
+
+        /*
+         * paused with nothing left to publish, only a command, unpausing or
+         * closing brings more work, and each of those wakes the thread; one
+         * since the top of the loop makes the wait return at once
+         */
+        if (this->g_paused && !dirty) {
+
+            this->g_sim_wakes.wait(wakes, std::memory_order_acquire);
+            continue;
+        }
+
+        /* short naps keep edits responsive while nothing is due */
+        if (!generations) {
+
+            double idle = (this->g_paused) ? 0.002
+                : std::min(scheduler.idle_time(), 0.002);
+            std::this_thread::sleep_for(std::chrono::duration<double>(idle));
+        }
+    }
 }
 
+/* zooms by factor, keeping the board point under pixel (x, y) where it is */
 void
-Game::select_glider(int x, int y)
+Game::zoom_at(double factor, int x, int y)
 {
-    this->renderer()->draw_selection_box((x - 1) * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box(x * 10, (y - 2) * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 1) * 10, y * 10, 255, 0, 0, 255);
-    this->renderer()->draw_selection_box((x + 1) * 10, (y - 1) * 10, 255, 0, 0, 255);
+    double min_zoom = std::min(this->g_fit_zoom, 1.0) / 4;
+    double zoom = std::clamp(this->g_zoom * factor, min_zoom, G_MAX_ZOOM);
+
+    this->g_view_x += x / this->g_zoom - x / zoom;
+    this->g_view_y += y / this->g_zoom - y / zoom;
+    this->g_zoom = zoom;
+    this->g_redraw = true;
 }
 
+/* drags the board by (dx, dy) pixels */
 void
-Game::place_cell(int x, int y, int val)
+Game::pan(double dx, double dy)
 {
-    this->set_cell(x, y, val);
+    this->g_view_x -= dx / this->g_zoom;
+    this->g_view_y -= dy / this->g_zoom;
+    this->g_redraw = true;
 }
 
 void
-Game::place_block(int x, int y, int val)
+Game::reset_view(void)
 {
-    this->set_cell(x, y, val);
-    this->set_cell(x, y + 1, val);
-    this->set_cell(x + 1, y, val);
-    this->set_cell(x + 1, y + 1, val);
+    this->g_zoom = this->g_fit_zoom;
+    this->g_view_x = 0;
+    this->g_view_y = 0;
+    this->g_redraw = true;
 }
 
+/*
+ * uploads just the part of the board the camera can see. At one pixel per
+ * cell or more that is the cells themselves; zoomed out further it is the
+ * pyramid level whose blocks are a pixel or just under, so the work done is
+ * bounded by the window, not the board
+ */
+void
+Game::upload_view(BoardView const& view)
+{
+    int out_width;
+    int out_height;
+    int level = 0;
+
+    this->g_src = {0, 0, 0, 0};
+    if (this->renderer()->output_size(&out_width, &out_height))
+        return;
+
+    if (this->g_zoom < 1)
+        level = std::min(static_cast<int>(std::ceil(std::log2(1 / this->g_zoom))),
+                this->g_pyramid.top_level());
+
+    double block = std::ldexp(1.0, level);
+    int blocks_x = ((view.width - 1) >> level) + 1;
+    int blocks_y = ((view.height - 1) >> level) + 1;
+    int x0 = std::max(0, static_cast<int>(std::floor(this->g_view_x / block)));
+    int y0 = std::max(0, static_cast<int>(std::floor(this->g_view_y / block)));
+    int x1 = std::min(blocks_x, static_cast<int>(std::ceil(
+                    (this->g_view_x + out_width / this->g_zoom) / block)));
+    int y1 = std::min(blocks_y, static_cast<int>(std::ceil(
+                    (this->g_view_y + out_height / this->g_zoom) / block)));
+    SDL_Rect region = {x0, y0, x1 - x0, y1 - y0};
+
+    if (region.w <= 0 || region.h <= 0)
+        return;
+    if (this->renderer()->upload_blocks(view, this->g_pyramid, level, region, region))
+        return;
+
+    double scale = block * this->g_zoom;
+
+    this->g_level = level;
+    this->g_region = region;
+    this->g_src = {0, 0, region.w, region.h};
+    this->g_dst = {
+        static_cast<int>(std::lround((x0 * block - this->g_view_x) * this->g_zoom)),
+        static_cast<int>(std::lround((y0 * block - this->g_view_y) * this->g_zoom)),
+        static_cast<int>(std::lround(region.w * scale)),
+        static_cast<int>(std::lround(region.h * scale)),
+    };
+}
+
+/*
+ * rewrites the blocks under each horizontal run of dirty tiles in the
+ * current image, so a new generation costs what it changed, not what is
+ * alive or in view
+ */
 void
-Game::place_beehive(int x, int y, int val)
+Game::update_view(BoardView const& view, std::vector<uint8_t> const& dirty)
 {
-    this->set_cell(x - 1, y, val);
-    this->set_cell(x, y - 1, val);
-    this->set_cell(x, y + 1, val);
-    this->set_cell(x + 1, y - 1, val);
-    this->set_cell(x + 1, y + 1, val);
-    this->set_cell(x + 2, y, val);
+    int tiles_x = view.words;
+    int tiles_y = (view.height + B_TILE_ROWS - 1) / B_TILE_ROWS;
+    int level = this->g_level;
+
+    if (!this->g_src.w)
+        return;
+
+    for (int ty = 0; ty < tiles_y; ty++) {
+
+        uint8_t const *row = dirty.data() + static_cast<size_t>(ty) * tiles_x;
+
+        for (int tx = 0; tx < tiles_x; tx++) {
+
+            if (!row[tx])
+                continue;
+
+            int first = tx;
+            while (tx + 1 < tiles_x && row[tx + 1])
+                tx++;
+
+            /* the run's cells, clipped to the board, then its blocks */
+            int x1 = std::min(view.width, (tx + 1) * 64) - 1;
+            int y1 = std::min(view.height, (ty + 1) * B_TILE_ROWS) - 1;
+            int bx = (first * 64) >> level;
+            int by = (ty * B_TILE_ROWS) >> level;
+            SDL_Rect part = {bx, by, (x1 >> level) - bx + 1, (y1 >> level) - by + 1};
+
+            if (this->renderer()->upload_blocks(view, this->g_pyramid, level,
+                        this->g_region, part))
+                return;
+        }
+    }
 }
 
+/* the camera moving redraws the image, a new generation patches it */
 void
-Game::place_loaf(int x, int y, int val)
+Game::display_board(void)
 {
-    this->set_cell(x - 1, y, val);
-    this->set_cell(x, y - 1, val);
-    this->set_cell(x, y + 1, val);
-    this->set_cell(x + 1, y - 1, val);
-    this->set_cell(x + 1, y + 2, val);
-    this->set_cell(x + 2, y, val);
-    this->set_cell(x + 2, y + 1, val);
+    ProfileScope scope(this->g_profiler, PF_DISPLAY);
+
+    if (this->g_snapshots.update()) {
+
+        Snapshot const& snap = this->g_snapshots.front();
+
+        for (int z = PF_STEP; z < PF_ZONES; z++)
+            this->g_frame.seconds[z] += snap.stats.seconds[z];
+        this->g_frame.generation = snap.stats.generation;
+        this->g_frame.population = snap.stats.population;
+        this->g_frame.births += snap.stats.births;
+        this->g_frame.deaths += snap.stats.deaths;
+
+        this->g_pyramid.update(snap.view, snap.dirty.data());
+        if (!this->g_redraw)
+            this->update_view(snap.view, snap.dirty);
+    }
+
+    BoardView const& view = this->g_snapshots.front().view;
+
+    if (!view.cells)
+        return;
+    if (this->g_redraw) {
+
+        this->upload_view(view);
+        this->g_redraw = false;
+    }
+    if (this->g_src.w)
+        this->renderer()->draw_board(&this->g_src, &this->g_dst);
 }
 
 void
-Game::place_boat(int x, int y, int val)
+Game::loop(void)
 {
-    this->set_cell(x - 1, y - 1, val);
-    this->set_cell(x - 1, y, val);
-    this->set_cell(x, y - 1, val);
-    this->set_cell(x, y + 1, val);
-    this->set_cell(x + 1, y, val);
+    SDL_Event       event;
+    int             err;
+
+    this->g_sim_running = true;
+    this->g_sim_thread = std::thread(&Game::simulate, this);
+
+    while (this->g_state == G_RUNNING) {
+
+        /*
+         * the frame only changes with input or a new snapshot, so rather
+         * than redraw the same one, sleep until there is one of those;
+         * while paused, snapshots only come from edits, so sleep longer
+         */
+        if (this->g_snapshots.consumed() && !this->g_redraw) {
+
+            int woken;
+            {
+                ProfileScope scope(this->g_profiler, PF_WAIT);
+
+                woken = SDL_WaitEventTimeout(&event, (this->g_paused)
+                        ? G_IDLE_WAIT_MS : G_FRAME_WAIT_MS);
+            }
+            if (woken) {
+
+                ProfileScope scope(this->g_profiler, PF_EVENTS);
+
+                this->handle_event(&event);
+            } else if (this->g_snapshots.consumed()) {
+
+                continue;
+            }
+        }
+
+        if (err = SDL_ShowCursor(SDL_DISABLE), err < 0)
+            this->g_state = G_STOPPED;
+
+        this->g_renderer->clear();
+        this->handle_keyboard(&event);
+        this->display_board();
+        this->handle_mouse();
+        if (this->g_profiler.overlay())
+            this->draw_overlay();
+        {
+            ProfileScope scope(this->g_profiler, PF_PRESENT);
+
+            this->g_renderer->present();
+        }
+        this->end_frame();
+    }
+
+    this->g_sim_running = false;
+    this->wake_sim();
+    this->g_sim_thread.join();
+
+    if (!this->g_trace_path.empty() && !this->g_profiler.write(
+                this->g_trace_path.c_str()))
+        fprintf(stderr, "[INFO] :: %s :: wrote trace to %s\n", __func__,
+                this->g_trace_path.c_str());
 }
 
+/*
+ * hands the finished frame to the profiler: the render thread's zones and
+ * draw calls, and whatever the snapshots it picked up brought with them
+ */
 void
-Game::place_tub(int x, int y, int val)
+Game::end_frame(void)
 {
-    this->set_cell(x - 1, y, val);
-    this->set_cell(x, y - 1, val);
-    this->set_cell(x, y + 1, val);
-    this->set_cell(x + 1, y, val);
+    this->g_frame.draw_calls = this->renderer()->take_draw_calls();
+    if (!this->g_profiler.enabled())
+        return;
+
+    this->g_frame.time = this->g_profiler.now();
+    for (int z = 0; z < PF_STEP; z++)
+        this->g_frame.seconds[z] = this->g_profiler.take(static_cast<ProfileZone>(z));
+    this->g_profiler.frame(this->g_frame);
+
+    for (int z = PF_STEP; z < PF_ZONES; z++)
+        this->g_frame.seconds[z] = 0;
+    this->g_frame.births = 0;
+    this->g_frame.deaths = 0;
 }
 
+/*
+ * the profiler's figures over the top-left corner of the board: the board,
+ * the rates, the draw calls of the last frame, and the milliseconds each
+ * zone took per frame on average, the sim thread's included
+ */
 void
-Game::place_blinker(int x, int y, int val)
-{
-    this->set_cell(x, y - 1, val);
-    this->set_cell(x, y, val);
-    this->set_cell(x, y + 1, val);
+Game::draw_overlay(void)
+{
+    ProfileScope scope(this->g_profiler, PF_OVERLAY);
+    ProfileFrame const& last = this->g_profiler.last();
+    char lines[2 + (PF_ZONES + 2) / 3][96];
+    int count = 0;
+    size_t widest = 0;
+
+    snprintf(lines[count++], sizeof(lines[0]), "gen %llu  pop %llu  +%llu -%llu",
+            static_cast<unsigned long long>(last.generation),
+            static_cast<unsigned long long>(last.population),
+            static_cast<unsigned long long>(last.births),
+            static_cast<unsigned long long>(last.deaths));
+    snprintf(lines[count++], sizeof(lines[0]), "%.0f fps  %.0f gen/s  %llu draws",
+            this->g_profiler.fps(), this->g_profiler.rate(),
+            static_cast<unsigned long long>(last.draw_calls));
+
+    for (int z = 0; z < PF_ZONES; z += 3, count++) {
+
+        int used = 0;
+
+        for (int i = z; i < std::min(z + 3, int(PF_ZONES)); i++)
+            used += snprintf(lines[count] + used, sizeof(lines[0]) - used,
+                    "%s%s %.2f", (i == z) ? "" : "  ",
+                    profile_zone_name(static_cast<ProfileZone>(i)),
+                    this->g_profiler.average(static_cast<ProfileZone>(i)) * 1e3);
+        snprintf(lines[count] + used, sizeof(lines[0]) - used, " ms");
+    }
+
+    for (int i = 0; i < count; i++)
+        widest = std::max(widest, strlen(lines[i]));
+
+    /* the brush preview queued so far goes under the panel, the text over it */
+    this->renderer()->add_fill({0, 0,
+            static_cast<int>(widest) * 8 + 2 * G_OVERLAY_MARGIN,
+            count * G_OVERLAY_LINE + 2 * G_OVERLAY_MARGIN - 2}, 0, 0, 0, 192);
+    this->renderer()->flush();
+    for (int i = 0; i < count; i++)
+        this->renderer()->draw_text(G_OVERLAY_MARGIN,
+                static_cast<int16_t>(G_OVERLAY_MARGIN + i * G_OVERLAY_LINE),
+                lines[i], 255, 255, 255, 255);
 }
 
 void
-Game::place_toad(int x, int y, int val)
+Game::next_brush(int delta)
 {
-    this->set_cell(x - 1, y, val);
-    this->set_cell(x, y - 1, val);
-    this->set_cell(x, y, val);
-    this->set_cell(x + 1, y - 1, val);
-    this->set_cell(x + 1, y, val);
-    this->set_cell(x + 2, y - 1, val);
+    int size = static_cast<int>(this->g_brushes.size());
+    this->g_brush += delta;
+    if (this->g_brush >= size)
+        this->g_brush = 0;
+    if (this->g_brush < 0)
+        this->g_brush = size - 1;
 }
 
+/* outlines the cell at board position (x, y) under the cursor */
 void
-Game::place_beacon(int x, int y, int val)
+Game::highlight_cell(int x, int y)
 {
-    this->set_cell(x - 1, y - 2, val);
-    this->set_cell(x - 1, y - 1, val);
-    this->set_cell(x, y - 2, val);
-    this->set_cell(x + 1, y + 1, val);
-    this->set_cell(x + 2, y, val);
-    this->set_cell(x + 2, y + 1, val);
+    double px = std::floor((x - this->g_view_x) * this->g_zoom);
+    double py = std::floor((y - this->g_view_y) * this->g_zoom);
+    int size = std::max(1, static_cast<int>(this->g_zoom));
+
+    /* far off the window, which also keeps the casts in range */
+    if (px < -size || py < -size || px > INT16_MAX - size || py > INT16_MAX - size)
+        return;
+
+    this->renderer()->add_outline({static_cast<int>(px), static_cast<int>(py),
+            size + 1, size + 1}, 255, 0, 0, 255);
 }
 
+/*
+ * shows where the current brush would go with the cursor on cell (x, y):
+ * every cell of it, or the box around it once there are too many to draw
+ */
 void
-Game::place_glider(int x, int y, int val)
+Game::highlight_brush(int x, int y)
 {
-    this->set_cell(x - 1, y, val);
-    this->set_cell(x, y, val);
-    this->set_cell(x, y - 2, val);
-    this->set_cell(x + 1, y, val);
-    this->set_cell(x + 1, y - 1, val);
+    Brush const& brush = this->g_brushes[this->g_brush];
+
+    if (brush.cells() <= G_HIGHLIGHT_CELLS) {
+
+        brush.for_each_cell([&](int dx, int dy) {
+            this->highlight_cell(x + dx, y + dy);
+        });
+        return;
+    }
+
+    double x0 = std::floor((x - brush.origin_x() - this->g_view_x) * this->g_zoom);
+    double y0 = std::floor((y - brush.origin_y() - this->g_view_y) * this->g_zoom);
+    double x1 = x0 + std::max(1.0, std::ceil(brush.width() * this->g_zoom));
+    double y1 = y0 + std::max(1.0, std::ceil(brush.height() * this->g_zoom));
+
+    /* clipped well outside the window, which keeps the casts in range */
+    x0 = std::clamp(x0, double(INT16_MIN), double(INT16_MAX));
+    y0 = std::clamp(y0, double(INT16_MIN), double(INT16_MAX));
+    x1 = std::clamp(x1, double(INT16_MIN), double(INT16_MAX));
+    y1 = std::clamp(y1, double(INT16_MIN), double(INT16_MAX));
+
+    this->renderer()->add_outline({static_cast<int>(x0), static_cast<int>(y0),
+            static_cast<int>(x1 - x0), static_cast<int>(y1 - y0)}, 255, 0, 0, 255);
 }
@@ -10,7 +10,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <string>
+#include <thread>
 #include <vector>
 #include <cstdint>
 
@@ -22,95 +25,150 @@
     #include <SDL.h>
 #endif
 
+#include "cgol.hpp"
+#include "rule.hpp"
+#include "board.hpp"
+#include "brush.hpp"
+#include "cycle.hpp"
+#include "history.hpp"
+#include "checkpoint.hpp"
+#include "profile.hpp"
 #include "window.hpp"
+#include "pyramid.hpp"
 #include "renderer.hpp"
+#include "commandqueue.hpp"
+#include "triplebuffer.hpp"
+
+#define G_DEFAULT_BOARD_SIZE 80
+#define G_WINDOW_SIZE 800       /* the window a board is scaled to fit */
+#define G_MAX_WINDOW_SIZE 1600
+#define G_COMMAND_QUEUE_SIZE 4096
+#define G_DEFAULT_RATE 5            /* generations per second */
+#define G_MAX_RATE (1 << 20)
+#define G_FRAME_BUDGET (1.0 / 60)   /* seconds of stepping per published frame */
+#define G_IDLE_WAIT_MS 100          /* longest a paused window sleeps on input */
+#define G_FRAME_WAIT_MS 2           /* longest a new generation waits to be drawn */
+#define G_MAX_ZOOM 64.0             /* pixels per cell side */
+#define G_ZOOM_STEP 2.0
+#define G_SEEK_STEP 100             /* generations per shifted rewind key */
+#define G_DEFAULT_CHECKPOINT "cgol.ckpt"
+#define G_HIGHLIGHT_CELLS 256       /* larger brushes are outlined, not drawn */
+#define G_OVERLAY_MARGIN 4          /* pixels around the overlay's text */
+#define G_OVERLAY_LINE 10           /* pixels from one line of it to the next */
 
 class Game
 {
     private:
         std::shared_ptr<Window> g_window;
         std::shared_ptr<Renderer> g_renderer;
-        std::vector<uint8_t> g_board;
-        std::vector<uint8_t> g_next_iteration;
-        std::vector<std::pair<int,int>> g_alive_cells;
+        Simulation g_sim;                       /* owned by the sim thread */
+        History g_history;                      /* and the generations before it */
+        std::string g_checkpoint_path;          /* where k saves the board */
+        uint64_t g_births;                      /* stepped since the last snapshot, */
+        uint64_t g_deaths;                      /* counted while profiling */
+        std::vector<Brush> g_brushes;           /* fixed once loop() starts */
         int g_brush;
-        bool g_paused;
 
-        enum State {
-            G_RUNNING,
-            G_STOPPED,
+        /* the camera: pixels per cell side, and the board point at the top-left */
+        double g_zoom;
+        double g_fit_zoom;                      /* zoom that fits the whole board */
+        double g_view_x;
+        double g_view_y;
+
+        /*
+         * the board image kept in the renderer's texture: the blocks of
+         * g_region at pyramid level g_level. New generations only rewrite
+         * the tiles they changed; moving the camera redoes the whole thing
+         */
+        DensityPyramid g_pyramid;               /* owned by the render thread */
+        int g_level;
+        SDL_Rect g_region;
+        SDL_Rect g_src;
+        SDL_Rect g_dst;
+        bool g_redraw;
+
+        Profiler g_profiler;
+        ProfileFrame g_frame;                   /* the one being drawn */
+        std::string g_trace_path;               /* written when the window closes */
+
+        /* a finished generation, copied out for the render thread */
+        struct Snapshot {
+            std::vector<uint64_t> cells;
+            BoardView view = {};
+            std::vector<uint8_t> dirty;         /* tiles changed since the last one */
+            uint64_t generation = 0;
+            ProfileFrame stats = {};            /* the sim thread's part */
         };
-        State g_state;
 
-        std::vector<void (Game::*)(int, int)> const g_brush_selections = {
-            &Game::select_cell,
-            &Game::select_block,
-            &Game::select_beehive,
-            &Game::select_loaf,
-            &Game::select_boat,
-            &Game::select_tub,
-            &Game::select_blinker,
-            &Game::select_toad,
-            &Game::select_beacon,
-            &Game::select_glider,
+        /* an edit made on the render thread, applied between generations */
+        struct Command {
+            enum Type : uint8_t {
+                G_STAMP,                        /* brush, cursor on (x, y) */
+                G_CLEAR,
+                G_SEEK,                         /* x generations from the current one */
+                G_SAVE,                         /* write a checkpoint */
+            } type;
+            uint8_t value;
+            int x;
+            int y;
+            int brush = 0;                      /* index into g_brushes, for G_STAMP */
         };
 
-        std::vector<void (Game::*)(int, int, int)> const g_brush_placements = {
-            &Game::place_cell,
-            &Game::place_block,
-            &Game::place_beehive,
-            &Game::place_loaf,
-            &Game::place_boat,
-            &Game::place_tub,
-            &Game::place_blinker,
-            &Game::place_toad,
-            &Game::place_beacon,
-            &Game::place_glider,
+        TripleBuffer<Snapshot> g_snapshots;
+        CommandQueue<Command, G_COMMAND_QUEUE_SIZE> g_commands;
+        std::thread g_sim_thread;
+        std::atomic<bool> g_sim_running;
+        std::atomic<bool> g_paused;
+        std::atomic<uint32_t> g_sim_wakes;      /* bumped to wake a paused sim thread */
+        std::atomic<int> g_rate;                /* per second, or S_UNLIMITED */
+        int g_last_rate;                        /* restored when leaving unlimited */
+
+        enum State {
+            G_RUNNING,
+            G_STOPPED,
         };
+        State g_state;
 
         std::shared_ptr<Window> window(void) { return this->g_window; }
         std::shared_ptr<Renderer> renderer(void) { return this->g_renderer; }
 
         void handle_mouse(void);
-        void handle_keyboard(SDL_Event *, int *);
-        void set_cell(int, int, uint8_t);
-        [[ nodiscard ]] uint8_t get_cell(int, int) const;
-        [[ nodiscard ]] int calculate_neighbour_count(int, int) const;
+        void handle_keyboard(SDL_Event *);
+        void handle_event(SDL_Event *);
+        void stamp(int, int, uint8_t);
         void display_board(void);
-        void next_iteration(void);
+        void draw_overlay(void);
+        void end_frame(void);
+        void upload_view(BoardView const&);
+        void update_view(BoardView const&, std::vector<uint8_t> const&);
+        void zoom_at(double, int, int);
+        void pan(double, double);
+        void reset_view(void);
+        void simulate(void);
+        void push_command(Command const&);
+        void wake_sim(void);
+        void apply_command(Command const&);
+        void publish_snapshot(void);
+        void record(void);
+        void stepped(void);
+        void seek(int);
         void clear_board(void);
         void next_brush(int);
-
-        void remember_cell(int, int);
-        void forget_cell(int, int);
-
-        void place_cell(int, int, int);
-        void place_block(int, int, int);
-        void place_beehive(int, int, int);
-        void place_loaf(int, int, int);
-        void place_boat(int, int, int);
-        void place_tub(int, int, int);
-        void place_blinker(int, int, int);
-        void place_toad(int, int, int);
-        void place_beacon(int, int, int);
-        void place_glider(int, int, int);
-
-        void select_cell(int, int);
-        void select_block(int, int);
-        void select_beehive(int, int);
-        void select_loaf(int, int);
-        void select_boat(int, int);
-        void select_tub(int, int);
-        void select_blinker(int, int);
-        void select_toad(int, int);
-        void select_beacon(int, int);
-        void select_glider(int, int);
+        void highlight_cell(int, int);
+        void highlight_brush(int, int);
 
     public:
-#define G_BOARD_SIZE 80
-        Game(void);
+        Game(int, int, double zoom = 0, int threads = 0);
         ~Game(void);
 
-        int init(int unsigned, int unsigned);
+        int init(void);
+        int load_pattern(char const *);
+        int add_brush(char const *);
+        int load_checkpoint(Checkpoint const&);
+        void set_checkpoint_path(char const *);
+        void set_trace(char const *);
+        void set_rate(int);
+        void set_rule(Rule const&);
+        void set_history(size_t, int);
         void loop(void);
 };
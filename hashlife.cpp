@@ -0,0 +1,556 @@
+/**
+ * HASHLIFE:
+ *  This file contains the HashLife engine for Conway's Game of Life
+ *
+ *  Nodes are carved out of fixed-size arena blocks and hash-consed through
+ *  an intrusive chained table, so a node is only ever created once for a
+ *  given set of children. When the live node count passes the configured
+ *  budget, everything not reachable from the root is swept back onto the
+ *  arena's free list between steps.
+ *
+ *  file: hashlife.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+
+#include "rule.hpp"
+#include "hashlife.hpp"
+
+/* the root never shrinks below an 8x8 square */
+#define H_MIN_LEVEL 3
+
+static inline size_t
+hash_children(void const *nw, void const *ne, void const *sw, void const *se)
+{
+    uint64_t h = reinterpret_cast<uintptr_t>(nw);
+
+    h = h * 0x9E3779B97F4A7C15ull + reinterpret_cast<uintptr_t>(ne);
+    h = h * 0x9E3779B97F4A7C15ull + reinterpret_cast<uintptr_t>(sw);
+    h = h * 0x9E3779B97F4A7C15ull + reinterpret_cast<uintptr_t>(se);
+    return static_cast<size_t>(h ^ (h >> 29));
+}
+
+HashLife::HashLife(size_t max_nodes)
+{
+    this->h_free = nullptr;
+    this->h_nodes = 0;
+    this->h_max_nodes = max_nodes;
+    this->h_table = std::vector<Node *>(1 << 16, nullptr);
+    this->h_generation = 0;
+    this->h_rule = R_CONWAY;
+
+    /* the two leaves are the only nodes that never go through join */
+    this->h_dead = this->allocate();
+    this->h_alive = this->allocate();
+    *this->h_dead = Node{};
+    *this->h_alive = Node{};
+    this->h_alive->population = 1;
+
+    this->h_root = this->empty(H_MIN_LEVEL);
+}
+
+HashLife::Node *
+HashLife::allocate(void)
+{
+    if (!this->h_free) {
+
+        this->h_arena.emplace_back(std::make_unique<Node[]>(H_ARENA_BLOCK));
+
+        Node *block = this->h_arena.back().get();
+        for (size_t i = 0; i < H_ARENA_BLOCK; i++) {
+
+            block[i].next = this->h_free;
+            this->h_free = &block[i];
+        }
+    }
+
+    Node *node = this->h_free;
+    this->h_free = node->next;
+    return (node);
+}
+
+void
+HashLife::rehash(void)
+{
+    std::vector<Node *> table(this->h_table.size() * 2, nullptr);
+    size_t mask = table.size() - 1;
+
+    for (Node *chain : this->h_table) {
+
+        while (chain) {
+
+            Node *next = chain->next;
+            size_t slot = hash_children(chain->nw, chain->ne, chain->sw,
+                    chain->se) & mask;
+
+            chain->next = table[slot];
+            table[slot] = chain;
+            chain = next;
+        }
+    }
+    this->h_table = std::move(table);
+}
+
+HashLife::Node *
+HashLife::join(Node *nw, Node *ne, Node *sw, Node *se)
+{
+    size_t slot = hash_children(nw, ne, sw, se) & (this->h_table.size() - 1);
+
+    for (Node *node = this->h_table[slot]; node; node = node->next) {
+
+        if (node->nw == nw && node->ne == ne && node->sw == sw && node->se == se)
+            return (node);
+    }
+
+    Node *node = this->allocate();
+    node->nw = nw;
+    node->ne = ne;
+    node->sw = sw;
+    node->se = se;
+    node->result = nullptr;
+    node->population = nw->population + ne->population + sw->population
+        + se->population;
+    node->level = nw->level + 1;
+    node->result_step = -1;
+    node->marked = 0;
+    node->next = this->h_table[slot];
+    this->h_table[slot] = node;
+
+    if (++this->h_nodes > this->h_table.size())
+        this->rehash();
+
+    return (node);
+}
+
+HashLife::Node *
+HashLife::empty(int level)
+{
+    if (this->h_empty.empty())
+        this->h_empty.push_back(this->h_dead);
+
+    while (static_cast<int>(this->h_empty.size()) <= level) {
+
+        Node *e = this->h_empty.back();
+        this->h_empty.push_back(this->join(e, e, e, e));
+    }
+
+    return (this->h_empty[level]);
+}
+
+HashLife::Node *
+HashLife::centre(Node *m)
+{
+    return this->join(m->nw->se, m->ne->sw, m->sw->ne, m->se->nw);
+}
+
+/* wraps the node in a border of empty space, keeping it centred */
+HashLife::Node *
+HashLife::expand(Node *m)
+{
+    Node *e = this->empty(m->level - 1);
+
+    return this->join(this->join(e, e, e, m->nw), this->join(e, e, m->ne, e),
+            this->join(e, m->sw, e, e), this->join(m->se, e, e, e));
+}
+
+/* true when every live cell of the node sits inside its inner quarter */
+bool
+HashLife::padded(Node *m) const
+{
+    return (m->nw->population == m->nw->se->se->population
+            && m->ne->population == m->ne->sw->sw->population
+            && m->sw->population == m->sw->ne->ne->population
+            && m->se->population == m->se->nw->nw->population);
+}
+
+/* advances the centre 2x2 of a 4x4 node by a single generation */
+HashLife::Node *
+HashLife::base_case(Node *m)
+{
+    uint32_t bits = 0;
+    Node *quads[4] = {m->nw, m->ne, m->sw, m->se};
+
+    for (int q = 0; q < 4; q++) {
+
+        int ox = (q & 1) * 2;
+        int oy = (q >> 1) * 2;
+        Node *cells[4] = {quads[q]->nw, quads[q]->ne, quads[q]->sw,
+            quads[q]->se};
+
+        for (int c = 0; c < 4; c++) {
+
+            if (cells[c]->population)
+                bits |= 1u << ((oy + (c >> 1)) * 4 + ox + (c & 1));
+        }
+    }
+
+    Node *out[4];
+    uint32_t rule = this->h_rule.bits();
+
+    for (int c = 0; c < 4; c++) {
+
+        int x = 1 + (c & 1);
+        int y = 1 + (c >> 1);
+        int neighbour_count = 0;
+
+        for (int dy = -1; dy <= 1; dy++) {
+
+            for (int dx = -1; dx <= 1; dx++) {
+
+                if (dx || dy)
+                    neighbour_count += (bits >> ((y + dy) * 4 + x + dx)) & 1;
+            }
+        }
+
+        bool alive = (bits >> (y * 4 + x)) & 1;
+        out[c] = ((rule >> (alive ? 9 + neighbour_count : neighbour_count)) & 1)
+            ? this->h_alive : this->h_dead;
+    }
+
+    return this->join(out[0], out[1], out[2], out[3]);
+}
+
+/*
+ * returns the centre of m, one level down, advanced by 2^step generations;
+ * step may be anything up to m->level - 2
+ */
+HashLife::Node *
+HashLife::successor(Node *m, int step)
+{
+    if (!m->population)
+        return this->empty(m->level - 1);
+
+    if (m->result_step == step)
+        return (m->result);
+
+    Node *result;
+
+    if (m->level == 2) {
+
+        result = this->base_case(m);
+    } else {
+
+        int inner = std::min(step, m->level - 3);
+
+        /* nine overlapping sub-squares, each advanced independently */
+        Node *c00 = this->successor(m->nw, inner);
+        Node *c01 = this->successor(this->join(m->nw->ne, m->ne->nw,
+                    m->nw->se, m->ne->sw), inner);
+        Node *c02 = this->successor(m->ne, inner);
+        Node *c10 = this->successor(this->join(m->nw->sw, m->nw->se,
+                    m->sw->nw, m->sw->ne), inner);
+        Node *c11 = this->successor(this->centre(m), inner);
+        Node *c12 = this->successor(this->join(m->ne->sw, m->ne->se,
+                    m->se->nw, m->se->ne), inner);
+        Node *c20 = this->successor(m->sw, inner);
+        Node *c21 = this->successor(this->join(m->sw->ne, m->se->nw,
+                    m->sw->se, m->se->sw), inner);
+        Node *c22 = this->successor(m->se, inner);
+
+        if (step < m->level - 2) {
+
+            /* already far enough in time, just stitch the centres */
+            result = this->join(
+                    this->join(c00->se, c01->sw, c10->ne, c11->nw),
+                    this->join(c01->se, c02->sw, c11->ne, c12->nw),
+                    this->join(c10->se, c11->sw, c20->ne, c21->nw),
+                    this->join(c11->se, c12->sw, c21->ne, c22->nw));
+        } else {
+
+            result = this->join(
+                    this->successor(this->join(c00, c01, c10, c11), inner),
+                    this->successor(this->join(c01, c02, c11, c12), inner),
+                    this->successor(this->join(c10, c11, c20, c21), inner),
+                    this->successor(this->join(c11, c12, c21, c22), inner));
+        }
+    }
+
+    m->result = result;
+    m->result_step = static_cast<int8_t>(step);
+    return (result);
+}
+
+HashLife::Node *
+HashLife::set_node(Node *m, uint64_t x, uint64_t y, bool alive)
+{
+    if (!m->level)
+        return (alive) ? this->h_alive : this->h_dead;
+
+    uint64_t h = uint64_t{1} << (m->level - 1);
+    Node *nw = m->nw, *ne = m->ne, *sw = m->sw, *se = m->se;
+
+    if (y < h) {
+
+        if (x < h)
+            nw = this->set_node(nw, x, y, alive);
+        else
+            ne = this->set_node(ne, x - h, y, alive);
+    } else {
+
+        if (x < h)
+            sw = this->set_node(sw, x, y - h, alive);
+        else
+            se = this->set_node(se, x - h, y - h, alive);
+    }
+
+    return this->join(nw, ne, sw, se);
+}
+
+void
+HashLife::set_cell(int64_t x, int64_t y, bool alive)
+{
+    while (x < -this->half() || x >= this->half() || y < -this->half()
+            || y >= this->half())
+        this->h_root = this->expand(this->h_root);
+
+    this->h_root = this->set_node(this->h_root,
+            static_cast<uint64_t>(x + this->half()),
+            static_cast<uint64_t>(y + this->half()), alive);
+}
+
+bool
+HashLife::get_cell(int64_t x, int64_t y) const
+{
+    if (x < -this->half() || x >= this->half() || y < -this->half()
+            || y >= this->half())
+        return (false);
+
+    Node const *m = this->h_root;
+    uint64_t b_x = static_cast<uint64_t>(x + this->half());
+    uint64_t b_y = static_cast<uint64_t>(y + this->half());
+
+    while (m->level && m->population) {
+
+        uint64_t h = uint64_t{1} << (m->level - 1);
+
+        if (b_y < h)
+            m = (b_x < h) ? m->nw : m->ne;
+        else
+            m = (b_x < h) ? m->sw : m->se;
+        b_x &= h - 1;
+        b_y &= h - 1;
+    }
+
+    return (m->population != 0);
+}
+
+/* memoised results were worked out under the old rule, so all of them go */
+void
+HashLife::set_rule(Rule const& rule)
+{
+    if (rule == this->h_rule)
+        return;
+
+    this->h_rule = rule;
+    for (Node *node : this->h_table) {
+
+        for (; node; node = node->next) {
+
+            node->result = nullptr;
+            node->result_step = -1;
+        }
+    }
+}
+
+void
+HashLife::clear(void)
+{
+    this->h_root = this->empty(H_MIN_LEVEL);
+    this->h_generation = 0;
+}
+
+/* advances the universe by 2^k generations */
+void
+HashLife::step(int k)
+{
+    if (this->h_nodes > this->h_max_nodes)
+        this->collect_garbage();
+
+    /* drop empty border left behind by earlier steps */
+    while (this->h_root->level > H_MIN_LEVEL
+            && this->centre(this->h_root)->population
+               == this->h_root->population)
+        this->h_root = this->centre(this->h_root);
+
+    while (this->h_root->level < k + 2 || !this->padded(this->h_root))
+        this->h_root = this->expand(this->h_root);
+
+    /* one more ring so nothing can leave the square while stepping */
+    this->h_root = this->successor(this->expand(this->h_root), k);
+    this->h_generation += uint64_t{1} << k;
+}
+
+/* advances by any number of generations, one power of two at a time */
+void
+HashLife::advance(uint64_t generations)
+{
+    for (int k = 0; generations; k++, generations >>= 1) {
+
+        if (generations & 1)
+            this->step(k);
+    }
+}
+
+void
+HashLife::mark(Node *node)
+{
+    while (node && !node->marked) {
+
+        node->marked = 1;
+        if (node->level) {
+
+            this->mark(node->nw);
+            this->mark(node->ne);
+            this->mark(node->sw);
+            this->mark(node->se);
+        }
+        node = node->result;
+    }
+}
+
+/*
+ * returns every node not reachable from the root, the cached empty nodes
+ * or the memoised results of those to the free list
+ */
+void
+HashLife::collect_garbage(void)
+{
+    this->mark(this->h_root);
+    for (Node *e : this->h_empty)
+        this->mark(e);
+
+    for (Node *& chain : this->h_table) {
+
+        Node **link = &chain;
+
+        while (*link) {
+
+            Node *node = *link;
+
+            if (node->marked) {
+
+                node->marked = 0;
+                link = &node->next;
+            } else {
+
+                *link = node->next;
+                node->next = this->h_free;
+                this->h_free = node;
+                this->h_nodes--;
+            }
+        }
+    }
+
+    this->h_dead->marked = 0;
+    this->h_alive->marked = 0;
+}
+
+/* builds the level-sized square at (x, y) of an 8x8 leaf bitmap */
+HashLife::Node *
+HashLife::leaf_node(uint64_t bits, int level, int x, int y)
+{
+    if (!level)
+        return ((bits >> (y * 8 + x)) & 1) ? this->h_alive : this->h_dead;
+
+    int h = 1 << (level - 1);
+    return this->join(this->leaf_node(bits, level - 1, x, y),
+            this->leaf_node(bits, level - 1, x + h, y),
+            this->leaf_node(bits, level - 1, x, y + h),
+            this->leaf_node(bits, level - 1, x + h, y + h));
+}
+
+uint64_t
+HashLife::leaf_bits(Node const *node) const
+{
+    uint64_t bits = 0;
+    auto set = [&bits](int64_t x, int64_t y) {
+        bits |= uint64_t{1} << (y * 8 + x);
+    };
+
+    this->walk(node, 0, 0, set);
+    return (bits);
+}
+
+/*
+ * replaces the universe with a Macrocell tree, its root centred on the
+ * origin; the generation count starts again from zero
+ */
+void
+HashLife::import_tree(std::vector<MacroNode> const& nodes)
+{
+    std::vector<Node *> built(nodes.size() + 1, nullptr);
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+
+        MacroNode const& m = nodes[i];
+
+        if (m.level == 3) {
+
+            built[i + 1] = this->leaf_node(m.leaf, 3, 0, 0);
+            continue;
+        }
+
+        Node *quads[4];
+        for (int q = 0; q < 4; q++) {
+
+            Node *child = (m.child[q] && m.child[q] <= i) ? built[m.child[q]]
+                                                          : nullptr;
+            quads[q] = (child && child->level == m.level - 1) ? child
+                : this->empty(m.level - 1);
+        }
+        built[i + 1] = this->join(quads[0], quads[1], quads[2], quads[3]);
+    }
+
+    this->h_root = (nodes.empty()) ? this->empty(H_MIN_LEVEL) : built.back();
+    while (this->h_root->level < H_MIN_LEVEL)
+        this->h_root = this->expand(this->h_root);
+    this->h_generation = 0;
+}
+
+/* flattens the universe into Macrocell order, sharing repeated nodes */
+std::vector<MacroNode>
+HashLife::export_tree(void) const
+{
+    std::vector<MacroNode> nodes;
+    std::unordered_map<Node const *, uint32_t> index;
+    std::vector<std::pair<Node const *, bool>> stack = {{this->h_root, false}};
+
+    /* iterative post-order, so children are always numbered first */
+    while (!stack.empty()) {
+
+        auto [node, expanded] = stack.back();
+        stack.pop_back();
+
+        if (!node->population || index.count(node))
+            continue;
+
+        if (node->level == 3) {
+
+            nodes.push_back({3, {0, 0, 0, 0}, this->leaf_bits(node)});
+            index[node] = static_cast<uint32_t>(nodes.size());
+        } else if (expanded) {
+
+            MacroNode m = {node->level, {0, 0, 0, 0}, 0};
+            Node const *quads[4] = {node->nw, node->ne, node->sw, node->se};
+
+            for (int q = 0; q < 4; q++)
+                m.child[q] = (quads[q]->population) ? index[quads[q]] : 0;
+            nodes.push_back(m);
+            index[node] = static_cast<uint32_t>(nodes.size());
+        } else {
+
+            stack.push_back({node, true});
+            stack.push_back({node->se, false});
+            stack.push_back({node->sw, false});
+            stack.push_back({node->ne, false});
+            stack.push_back({node->nw, false});
+        }
+    }
+
+    return (nodes);
+}
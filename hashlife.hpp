@@ -0,0 +1,135 @@
+/**
+ * HASHLIFE:
+ *  This file contains all prototypes and utilities needed for the HashLife
+ *  engine, an alternative to the dense Board stepper for Conway's Game of
+ *  Life and the other Life-like rules
+ *
+ *  The universe is a quadtree of hash-consed nodes, so identical regions
+ *  anywhere in space or time share one node, and every node memoises the
+ *  result of advancing its centre. Periodic and highly regular patterns
+ *  can then be advanced 2^k generations in a single call. Unlike Board,
+ *  the universe is an unbounded plane rather than a torus.
+ *
+ *  file: hashlife.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "rule.hpp"
+
+/*
+ * one node of a pattern tree in Macrocell order, where children always come
+ * before their parents and the last node is the root
+ */
+struct MacroNode {
+    int level;                  /* 3 for an 8x8 leaf */
+    uint32_t child[4];          /* nw, ne, sw, se: 1-based, 0 when empty */
+    uint64_t leaf;              /* leaf cells, bit y * 8 + x */
+};
+
+class HashLife
+{
+    private:
+        struct Node {
+            Node *nw;
+            Node *ne;
+            Node *sw;
+            Node *se;
+            Node *next;         /* hash chain, or free list when unused */
+            Node *result;       /* memoised centre advanced 2^result_step */
+            uint64_t population;
+            uint8_t level;      /* node covers 2^level x 2^level cells */
+            int8_t result_step;
+            uint8_t marked;
+        };
+
+        static constexpr size_t H_ARENA_BLOCK = 1 << 16;
+
+        std::vector<std::unique_ptr<Node[]>> h_arena;
+        Node *h_free;
+        std::vector<Node *> h_table;
+        std::vector<Node *> h_empty;
+        size_t h_nodes;
+        size_t h_max_nodes;
+
+        Node *h_dead;
+        Node *h_alive;
+        Node *h_root;
+        uint64_t h_generation;
+        Rule h_rule;
+
+        Node *allocate(void);
+        Node *join(Node *, Node *, Node *, Node *);
+        Node *empty(int);
+        Node *centre(Node *);
+        Node *expand(Node *);
+        Node *base_case(Node *);
+        Node *successor(Node *, int);
+        Node *set_node(Node *, uint64_t, uint64_t, bool);
+        void rehash(void);
+        void mark(Node *);
+        Node *leaf_node(uint64_t, int, int, int);
+        [[ nodiscard ]] uint64_t leaf_bits(Node const *) const;
+
+        [[ nodiscard ]] bool padded(Node *) const;
+        [[ nodiscard ]] int64_t half(void) const
+        {
+            return (int64_t{1} << (this->h_root->level - 1));
+        }
+
+        template <typename F>
+        void walk(Node const *node, int64_t x, int64_t y, F& fn) const
+        {
+            if (!node->population)
+                return;
+
+            if (!node->level) {
+
+                fn(x, y);
+                return;
+            }
+
+            int64_t h = int64_t{1} << (node->level - 1);
+            this->walk(node->nw, x, y, fn);
+            this->walk(node->ne, x + h, y, fn);
+            this->walk(node->sw, x, y + h, fn);
+            this->walk(node->se, x + h, y + h, fn);
+        }
+
+    public:
+        explicit HashLife(size_t max_nodes = size_t{1} << 22);
+
+        HashLife(HashLife const&) = delete;
+        HashLife& operator=(HashLife const&) = delete;
+
+        void set_cell(int64_t, int64_t, bool);
+        [[ nodiscard ]] bool get_cell(int64_t, int64_t) const;
+        void clear(void);
+
+        void step(int);
+        void advance(uint64_t);
+        void collect_garbage(void);
+        void set_rule(Rule const&);
+        [[ nodiscard ]] Rule const& rule(void) const { return this->h_rule; }
+
+        void import_tree(std::vector<MacroNode> const&);
+        [[ nodiscard ]] std::vector<MacroNode> export_tree(void) const;
+
+        [[ nodiscard ]] uint64_t generation(void) const { return this->h_generation; }
+        [[ nodiscard ]] uint64_t population(void) const { return this->h_root->population; }
+        [[ nodiscard ]] size_t node_count(void) const { return this->h_nodes; }
+
+        /* calls fn(x, y) for every live cell */
+        template <typename F>
+        void for_each_alive(F&& fn) const
+        {
+            this->walk(this->h_root, -this->half(), -this->half(), fn);
+        }
+};
@@ -0,0 +1,455 @@
+/**
+ * HEADLESS:
+ *  This file contains the batch runner for Conway's Game of Life
+ *
+ *  The runner loads a pattern into the chosen engine, advances it the
+ *  requested number of generations as fast as the engine allows, and
+ *  writes the final board as RLE, plaintext or Macrocell, with its timing
+ *  in the comments. A dense board that settles into a cycle is not
+ *  stepped any further than it takes to land on the same phase of the
+ *  cycle as the last generation would.
+ *
+ *  file: headless.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#include "rule.hpp"
+#include "board.hpp"
+#include "cycle.hpp"
+#include "checkpoint.hpp"
+#include "sparse.hpp"
+#include "pattern.hpp"
+#include "hashlife.hpp"
+#include "headless.hpp"
+#include "shard.hpp"
+#include "threadpool.hpp"
+
+/*
+ * the most live cells an unbounded engine writes as RLE or plaintext;
+ * they are gathered and sorted first, 16 bytes each
+ */
+#define H_MAX_WRITTEN_CELLS (uint64_t{1} << 32)
+
+template <typename F>
+static double
+timed_advance(F&& advance)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    advance();
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return (elapsed.count());
+}
+
+static std::string
+timing_comments(uint64_t generations, char const *engine,
+        Rule const& rule, uint64_t population, double seconds, double cells)
+{
+    char buf[256];
+    std::string out;
+
+    snprintf(buf, sizeof(buf), "engine: %s\nrule: %s\ngenerations: %llu\n"
+            "population: %llu\nseconds: %.6f\n", engine,
+            rule_string(rule).c_str(),
+            static_cast<unsigned long long>(generations),
+            static_cast<unsigned long long>(population), seconds);
+    out += buf;
+    if (seconds > 0) {
+
+        snprintf(buf, sizeof(buf), "generations_per_second: %.1f\n",
+                static_cast<double>(generations) / seconds);
+        out += buf;
+        if (cells > 0) {
+
+            snprintf(buf, sizeof(buf), "cells_per_second: %.4g\n",
+                    cells * static_cast<double>(generations) / seconds);
+            out += buf;
+        }
+    }
+
+    return (out);
+}
+
+/* --rule wins, then the rule the pattern file names, then Conway's */
+static int
+choose_rule(HeadlessOptions const& opts, PatternInfo const& info, Rule *rule)
+{
+    *rule = R_CONWAY;
+    if (opts.rule)
+        return parse_rule(opts.rule, rule);
+    if (!info.rule.empty())
+        return parse_rule(info.rule.c_str(), rule);
+
+    return (EXIT_SUCCESS);
+}
+
+/* picks the writer from --format, or else from the output file's extension */
+static char const *
+output_format(HeadlessOptions const& opts)
+{
+    if (opts.format)
+        return (opts.format);
+
+    char const *dot = (opts.output) ? strrchr(opts.output, '.') : nullptr;
+    if (dot && !strcmp(dot, ".rle"))
+        return ("rle");
+    if (dot && !strcmp(dot, ".mc"))
+        return ("mc");
+
+    return ("cells");
+}
+
+static int
+write_board(FILE *out, HeadlessOptions const& opts, Board const& board,
+        std::string const& comments)
+{
+    char const *format = output_format(opts);
+
+    if (!strcmp(format, "rle"))
+        return write_rle(out, board, comments.c_str());
+
+    if (!strcmp(format, "mc")) {
+
+        /* Macrocell is a quadtree format, so the board goes through one */
+        HashLife life;
+
+        life.set_rule(board.rule());
+        board.for_each_alive([&life](int x, int y) {
+            life.set_cell(x, y, true);
+        });
+        return write_macrocell(out, life, comments.c_str());
+    }
+
+    return write_plaintext(out, board, comments.c_str());
+}
+
+/*
+ * steps board until generation target, saving a checkpoint every so
+ * often and at the end if asked to, and stopping early at a cycle if
+ * asked to
+ */
+static int
+advance_dense(HeadlessOptions const& opts, Board& board, CycleDetector& cycles)
+{
+    while (board.generation() < opts.generations) {
+
+        uint64_t left = opts.generations - board.generation();
+
+        advance_through_cycles(board, cycles, (opts.checkpoint_every)
+                ? std::min(left, opts.checkpoint_every) : left,
+                opts.stop_on_cycle);
+        /* stopping on a cycle saves once, below */
+        if (opts.stop_on_cycle && cycles.period())
+            break;
+        if (opts.checkpoint && board.generation() < opts.generations
+                && write_checkpoint(opts.checkpoint, board))
+            return (EXIT_FAILURE);
+    }
+
+    if (opts.checkpoint)
+        return write_checkpoint(opts.checkpoint, board);
+
+    return (EXIT_SUCCESS);
+}
+
+/*
+ * a resumed board takes its size, cells, rule and generation from the
+ * checkpoint; --generations is then the generation to stop at, so the
+ * same command picks up where an interrupted run left off
+ */
+static int
+run_dense(HeadlessOptions const& opts, FILE *out)
+{
+    Checkpoint resume;
+    int width = opts.width;
+    int height = opts.height;
+    PatternInfo info;
+    CycleDetector cycles;
+    Rule rule;
+    std::string comments;
+    char engine[64];
+    double seconds;
+    uint64_t start;
+    int rc = EXIT_SUCCESS;
+
+    if (opts.resume) {
+
+        if (resume.open(opts.resume))
+            return (EXIT_FAILURE);
+        width = resume.width();
+        height = resume.height();
+        info.rule = rule_string(resume.rule());
+    }
+
+    Board board(width, height);
+    BoardSink sink(board);
+
+    board.set_pool(std::make_shared<ThreadPool>(opts.threads));
+    if (opts.resume && resume.load(board))
+        return (EXIT_FAILURE);
+    if (opts.input && read_pattern(opts.input, sink, &info))
+        return (EXIT_FAILURE);
+    if (choose_rule(opts, info, &rule))
+        return (EXIT_FAILURE);
+    board.set_rule(rule);
+
+    start = board.generation();
+    seconds = timed_advance([&]() { rc = advance_dense(opts, board, cycles); });
+    if (rc)
+        return (EXIT_FAILURE);
+
+    snprintf(engine, sizeof(engine), "dense (%s)", Board::kernel_name());
+    comments = timing_comments(board.generation() - start, engine, rule,
+            board.population(), seconds,
+            static_cast<double>(width) * height);
+    if (opts.resume)
+        comments += "resumed_from: " + std::to_string(start) + "\n";
+    if (cycles.period())
+        comments += "period: " + std::to_string(cycles.period())
+            + "\ncycle_start: " + std::to_string(cycles.start()) + "\n";
+
+    return write_board(out, opts, board, comments);
+}
+
+/* reads nothing but what a pattern file says about itself */
+class InfoSink : public PatternSink
+{
+    public:
+        void set_run(int64_t, int64_t, int64_t) override {}
+};
+
+/*
+ * the same across opts.shards processes, none of which holds the whole
+ * board: each worker loads, steps and writes its own band, the
+ * checkpoint and the pattern only ever being read from the files they
+ * are mapped from. The workers step every generation, as no one of them
+ * sees the whole board to notice a cycle, and checkpoint only at the end
+ */
+static int
+run_dense_sharded(HeadlessOptions const& opts, FILE *out)
+{
+    Checkpoint resume;
+    ShardPlan plan = {};
+    ShardRun run;
+    PatternInfo info;
+    InfoSink sink;
+    std::string comments;
+    char engine[64];
+    double seconds;
+    int rc = EXIT_SUCCESS;
+
+    plan.width = opts.width;
+    plan.height = opts.height;
+    if (opts.resume) {
+
+        if (resume.open(opts.resume))
+            return (EXIT_FAILURE);
+        plan.width = resume.width();
+        plan.height = resume.height();
+        plan.generation = resume.generation();
+        plan.resume = &resume;
+        info.rule = rule_string(resume.rule());
+    }
+
+    if (opts.input && read_pattern(opts.input, sink, &info))
+        return (EXIT_FAILURE);
+    if (choose_rule(opts, info, &plan.rule))
+        return (EXIT_FAILURE);
+
+    plan.generations = (opts.generations > plan.generation)
+        ? opts.generations - plan.generation : 0;
+    plan.input = opts.input;
+    plan.format = output_format(opts);
+    plan.checkpoint = (opts.checkpoint != nullptr);
+    plan.shards = opts.shards;
+    plan.threads = opts.threads;
+
+    seconds = timed_advance([&]() {
+        rc = run.run(plan);
+        if (!rc && opts.checkpoint)
+            rc = run.write_checkpoint(opts.checkpoint);
+    });
+    if (rc)
+        return (EXIT_FAILURE);
+
+    snprintf(engine, sizeof(engine), "dense (%s, %d shards)",
+            Board::kernel_name(), opts.shards);
+    comments = timing_comments(plan.generations, engine, plan.rule,
+            run.population(), seconds,
+            static_cast<double>(plan.width) * plan.height);
+    if (opts.resume)
+        comments += "resumed_from: " + std::to_string(plan.generation) + "\n";
+
+    return run.write(out, comments.c_str());
+}
+
+/*
+ * the unbounded engines have no fixed frame, so their live cells are
+ * gathered, moved so the box around them starts at the origin, and
+ * written a row at a time in order; memory follows the population, not
+ * the box. HashLife writes its own tree when the output is Macrocell
+ */
+template <typename E>
+static int
+run_unbounded(HeadlessOptions const& opts, FILE *out, char const *name)
+{
+    auto engine = std::make_unique<E>();
+    EngineSink<E> sink(*engine);
+    PatternInfo info;
+    Rule rule;
+    std::string comments;
+    double seconds;
+    int64_t min_x = INT64_MAX, min_y = INT64_MAX;
+    int64_t max_x = INT64_MIN, max_y = INT64_MIN;
+    std::vector<PatternCell> cells;
+    char const *format = output_format(opts);
+
+    if (opts.input && read_pattern(opts.input, sink, &info))
+        return (EXIT_FAILURE);
+    if (choose_rule(opts, info, &rule))
+        return (EXIT_FAILURE);
+    engine->set_rule(rule);
+
+    seconds = timed_advance([&]() { engine->advance(opts.generations); });
+    comments = timing_comments(opts.generations, name, rule,
+            engine->population(), seconds, 0);
+
+    if constexpr (std::is_same_v<E, HashLife>) {
+
+        if (!strcmp(format, "mc"))
+            return write_macrocell(out, *engine, comments.c_str());
+    }
+
+    if (engine->population() > H_MAX_WRITTEN_CELLS) {
+
+        fprintf(stderr, "[ERROR] :: %s :: %llu live cells are too many to "
+                "write as %s\n", __func__,
+                static_cast<unsigned long long>(engine->population()), format);
+        return (EXIT_FAILURE);
+    }
+
+    cells.reserve(engine->population());
+    engine->for_each_alive([&](int64_t x, int64_t y) {
+
+        cells.push_back({x, y});
+        min_x = std::min(min_x, x);
+        min_y = std::min(min_y, y);
+        max_x = std::max(max_x, x);
+        max_y = std::max(max_y, y);
+    });
+    if (min_x > max_x)
+        min_x = max_x = min_y = max_y = 0;
+
+    for (PatternCell& cell : cells) {
+
+        cell.x -= min_x;
+        cell.y -= min_y;
+    }
+    std::sort(cells.begin(), cells.end(),
+            [](PatternCell const& a, PatternCell const& b) {
+        return (a.y != b.y) ? a.y < b.y : a.x < b.x;
+    });
+
+    comments += "origin: " + std::to_string(min_x) + " "
+        + std::to_string(min_y) + "\n";
+
+    if (!strcmp(format, "rle"))
+        return write_rle(out, cells, max_x - min_x + 1, max_y - min_y + 1,
+                rule, comments.c_str());
+
+    if (!strcmp(format, "mc")) {
+
+        HashLife life;
+
+        life.set_rule(rule);
+        for (PatternCell const& cell : cells)
+            life.set_cell(cell.x, cell.y, true);
+        return write_macrocell(out, life, comments.c_str());
+    }
+
+    return write_plaintext(out, cells, max_y - min_y + 1, comments.c_str());
+}
+
+int
+run_headless(HeadlessOptions const& opts)
+{
+    FILE *out = stdout;
+    int rc;
+
+    if (opts.width <= 0 || opts.height <= 0) {
+
+        fprintf(stderr, "[ERROR] :: %s :: invalid board size %dx%d\n",
+                __func__, opts.width, opts.height);
+        return (EXIT_FAILURE);
+    }
+
+    if ((opts.resume || opts.checkpoint) && strcmp(opts.engine, "dense")) {
+
+        fprintf(stderr, "[ERROR] :: %s :: checkpoints need the dense engine\n",
+                __func__);
+        return (EXIT_FAILURE);
+    }
+
+    if (opts.shards > 1 && (strcmp(opts.engine, "dense")
+                || opts.stop_on_cycle || opts.checkpoint_every
+                || !strcmp(output_format(opts), "mc"))) {
+
+        fprintf(stderr, "[ERROR] :: %s :: shards need the dense engine and RLE "
+                "or plaintext output, and neither --stop-on-cycle nor "
+                "--checkpoint-every\n", __func__);
+        return (EXIT_FAILURE);
+    }
+
+    if (opts.format && strcmp(opts.format, "rle") && strcmp(opts.format, "cells")
+            && strcmp(opts.format, "mc")) {
+
+        fprintf(stderr, "[ERROR] :: %s :: unknown format %s\n", __func__,
+                opts.format);
+        return (EXIT_FAILURE);
+    }
+
+    if (opts.output && !(out = fopen(opts.output, "w"))) {
+
+        fprintf(stderr, "[ERROR] :: %s :: cannot open %s\n", __func__,
+                opts.output);
+        return (EXIT_FAILURE);
+    }
+
+    if (!strcmp(opts.engine, "dense") && opts.shards > 1) {
+
+        rc = run_dense_sharded(opts, out);
+    } else if (!strcmp(opts.engine, "dense")) {
+
+        rc = run_dense(opts, out);
+    } else if (!strcmp(opts.engine, "hashlife")) {
+
+        rc = run_unbounded<HashLife>(opts, out, "hashlife");
+    } else if (!strcmp(opts.engine, "sparse")) {
+
+        rc = run_unbounded<SparseUniverse>(opts, out, "sparse");
+    } else {
+
+        fprintf(stderr, "[ERROR] :: %s :: unknown engine %s\n", __func__,
+                opts.engine);
+        rc = EXIT_FAILURE;
+    }
+
+    if (out != stdout)
+        fclose(out);
+
+    return (rc);
+}
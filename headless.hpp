@@ -0,0 +1,32 @@
+/**
+ * HEADLESS:
+ *  This file contains all prototypes and utilities needed to run Conway's
+ *  Game of Life as a batch job, without SDL, a window or a video driver
+ *
+ *  file: headless.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <cstdint>
+
+struct HeadlessOptions {
+    char const *input;          /* RLE, plaintext or Macrocell, or nullptr */
+    char const *output;         /* final board and timing, or nullptr for stdout */
+    char const *format;         /* "rle", "cells", "mc", or nullptr to go by output */
+    char const *engine;         /* "dense", "hashlife" or "sparse" */
+    char const *rule;           /* name or B/S, or nullptr for the pattern's own */
+    char const *resume;         /* dense checkpoint to start from, or nullptr */
+    char const *checkpoint;     /* where to save checkpoints, or nullptr */
+    uint64_t checkpoint_every;  /* generations between them, 0 for only the last */
+    uint64_t generations;
+    bool stop_on_cycle;         /* stop at a cycle instead of skipping through it */
+    int width;                  /* dense board dimensions */
+    int height;
+    int threads;
+    int shards;                 /* worker processes for the dense board, 0 or 1 for none */
+};
+
+int run_headless(HeadlessOptions const&);
@@ -0,0 +1,301 @@
+/**
+ * HISTORY:
+ *  This file contains the rewind history of a board
+ *
+ *  file: history.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <bit>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#include "board.hpp"
+#include "history.hpp"
+
+/*
+ * a frame is a byte stream of the board's non-zero words, XORed into the
+ * board in order. Each word is written as a varint of the words skipped
+ * since the last one, a mask of which of its bytes are non-zero, and then
+ * those bytes, so a word with a few cells flipped takes three or four
+ * bytes. Words have to be put in board order, row by row
+ */
+struct FrameWriter {
+    std::vector<uint8_t>& bytes;
+    size_t used = 0;                /* bytes written, the rest is slack */
+    size_t next = 0;                /* board index after the last word put */
+
+    void put(size_t index, uint64_t word)
+    {
+        uint64_t low = 0x7f7f7f7f7f7f7f7f;
+        uint64_t high = (((word & low) + low) | word) & ~low;
+        unsigned mask = static_cast<unsigned>((high * 0x0002040810204081) >> 56);
+        uint8_t *at;
+
+        if (this->bytes.size() < this->used + 20)
+            this->bytes.resize(std::max(this->bytes.size() * 2, this->used + 20));
+        at = this->bytes.data() + this->used;
+
+        for (size_t skip = index - this->next; ; skip >>= 7) {
+
+            *at++ = (skip & 0x7f) | ((skip >= 0x80) ? 0x80 : 0);
+            if (skip < 0x80)
+                break;
+        }
+        *at++ = mask;
+        for (; mask; mask &= mask - 1)
+            *at++ = word >> (8 * std::countr_zero(mask));
+
+        this->used = at - this->bytes.data();
+        this->next = index + 1;
+    }
+
+    void finish(void)
+    {
+        this->bytes.resize(this->used);
+    }
+};
+
+History::History(size_t budget, int interval)
+{
+    this->hs_budget = budget;
+    this->hs_interval = std::max(interval, 1);
+    this->clear();
+}
+
+/* sets the memory budget in bytes, 0 to keep nothing, and the keyframe interval */
+void
+History::configure(size_t budget, int interval)
+{
+    this->hs_budget = budget;
+    this->hs_interval = std::max(interval, 1);
+    if (!budget)
+        this->clear();
+    this->evict();
+}
+
+void
+History::clear(void)
+{
+    this->hs_frames.clear();
+    this->hs_bytes = 0;
+    this->hs_resync = true;
+    this->hs_decoded = false;
+    this->hs_decoded_generation = 0;
+}
+
+void
+History::push(Frame&& frame)
+{
+    frame.bytes.shrink_to_fit();
+    this->hs_bytes += sizeof(Frame) + frame.bytes.size();
+    this->hs_frames.push_back(std::move(frame));
+}
+
+/* forgets generation and every one after it, as they are about to be redone */
+void
+History::drop_from(uint64_t generation)
+{
+    while (!this->hs_frames.empty() && this->newest() >= generation) {
+
+        Frame const& last = this->hs_frames.back();
+
+        this->hs_bytes -= sizeof(Frame) + last.bytes.size();
+        this->hs_frames.pop_back();
+    }
+    if (this->hs_decoded && this->hs_decoded_generation >= generation)
+        this->hs_decoded = false;
+}
+
+/* drops the oldest keyframe and its deltas while over budget, keeping the newest */
+void
+History::evict(void)
+{
+    while (this->hs_bytes > this->hs_budget && this->hs_frames.size() > 1) {
+
+        auto next_key = std::find_if(this->hs_frames.begin() + 1,
+                this->hs_frames.end(), [](Frame const& f) { return f.key; });
+
+        if (next_key == this->hs_frames.end())
+            break;
+
+        for (auto it = this->hs_frames.begin(); it != next_key; it++)
+            this->hs_bytes -= sizeof(Frame) + it->bytes.size();
+        this->hs_frames.erase(this->hs_frames.begin(), next_key);
+    }
+}
+
+/* index of the frame for generation, or SIZE_MAX if it is not kept */
+size_t
+History::find(uint64_t generation) const
+{
+    auto it = std::lower_bound(this->hs_frames.begin(), this->hs_frames.end(),
+            generation, [](Frame const& f, uint64_t g) {
+        return f.generation < g;
+    });
+
+    if (it == this->hs_frames.end() || it->generation != generation)
+        return (SIZE_MAX);
+
+    return static_cast<size_t>(it - this->hs_frames.begin());
+}
+
+void
+History::apply(Frame const& frame)
+{
+    uint8_t const *in = frame.bytes.data();
+    uint8_t const *end = in + frame.bytes.size();
+    size_t pos = 0;
+
+    if (frame.key)
+        std::fill(this->hs_cells.begin(), this->hs_cells.end(), 0);
+
+    while (in < end) {
+
+        uint64_t word = 0;
+        unsigned mask;
+
+        if (*in < 0x80) {
+
+            pos += *in++;
+        } else {
+
+            for (int shift = 0; ; shift += 7) {
+
+                pos += static_cast<size_t>(*in & 0x7f) << shift;
+                if (!(*in++ & 0x80))
+                    break;
+            }
+        }
+        for (mask = *in++; mask; mask &= mask - 1)
+            word |= static_cast<uint64_t>(*in++) << (8 * std::countr_zero(mask));
+        this->hs_cells[pos++] ^= word;
+    }
+    this->hs_decoded_generation = frame.generation;
+}
+
+/*
+ * adds the board's current generation, replacing it and anything after it
+ * if they were kept before. Has to be called after every generation and
+ * every edit for the deltas to hold, since a delta is read off the tiles
+ * the board says changed; a missed generation only costs a keyframe
+ */
+void
+History::record(Board const& board)
+{
+    uint64_t generation = board.generation();
+    size_t size = static_cast<size_t>(board.words()) * board.height();
+    int words = board.words();
+    Frame frame = {generation, false, {}};
+    FrameWriter writer = {frame.bytes};
+
+    if (!this->hs_budget)
+        return;
+    if (this->hs_cells.size() != size) {
+
+        this->clear();
+        this->hs_cells.assign(size, 0);
+    }
+    this->drop_from(generation);
+
+    frame.key = this->hs_resync || this->hs_frames.empty()
+        || this->newest() + 1 != generation;
+    for (auto it = this->hs_frames.rbegin(); !frame.key; it++) {
+
+        if (it->key) {
+
+            frame.key = generation - it->generation >= uint64_t(this->hs_interval);
+            break;
+        }
+    }
+
+    if (frame.key) {
+
+        for (int y = 0; y < board.height(); y++) {
+
+            uint64_t const *row = board.row(y);
+
+            for (int i = 0; i < words; i++) {
+
+                uint64_t word = (i == words - 1) ? row[i] & board.tail_mask()
+                                                 : row[i];
+                if (word)
+                    writer.put(static_cast<size_t>(y) * words + i, word);
+            }
+        }
+    } else {
+
+        std::vector<int> columns;
+
+        for (int ty = 0; ty < board.tiles_y(); ty++) {
+
+            columns.clear();
+            for (int tx = 0; tx < board.tiles_x(); tx++) {
+
+                if (board.tile_changed(tx, ty))
+                    columns.push_back(tx);
+            }
+
+            int last_row = std::min(board.height(), (ty + 1) * B_TILE_ROWS);
+
+            for (int y = ty * B_TILE_ROWS; !columns.empty() && y < last_row; y++) {
+
+                uint64_t const *row = board.row(y);
+                uint64_t const *prev = board.previous_row(y);
+
+                for (int i : columns) {
+
+                    uint64_t diff = row[i] ^ prev[i];
+
+                    if (i == words - 1)
+                        diff &= board.tail_mask();
+                    if (diff)
+                        writer.put(static_cast<size_t>(y) * words + i, diff);
+                }
+            }
+        }
+    }
+
+    writer.finish();
+    this->hs_resync = false;
+    this->push(std::move(frame));
+    this->evict();
+}
+
+/*
+ * puts board back to a kept generation; the next record() after that
+ * starts a new keyframe, since the board no longer knows what it was the
+ * generation before
+ */
+bool
+History::seek(uint64_t generation, Board& board)
+{
+    size_t at = this->find(generation);
+    size_t from;
+
+    if (at == SIZE_MAX || this->hs_cells.size()
+            != static_cast<size_t>(board.words()) * board.height())
+        return (false);
+
+    for (from = at; !this->hs_frames[from].key; from--)
+        ;
+
+    /* scrubbing forwards within one keyframe's deltas picks up where it was */
+    if (this->hs_decoded && this->hs_decoded_generation <= generation
+            && this->hs_decoded_generation >= this->hs_frames[from].generation)
+        from = this->find(this->hs_decoded_generation) + 1;
+
+    for (size_t i = from; i <= at; i++)
+        this->apply(this->hs_frames[i]);
+    this->hs_decoded = true;
+
+    board.restore(this->hs_cells.data(), generation);
+    this->hs_resync = true;
+
+    return (true);
+}
@@ -0,0 +1,84 @@
+/**
+ * HISTORY:
+ *  This file contains all prototypes and utilities needed for the rewind
+ *  history of a board
+ *
+ *  Every recorded generation is kept as a frame. Every hs_interval
+ *  generations, or whenever the chain is broken, the frame is a keyframe
+ *  holding the whole board; in between, a frame holds only the XOR of the
+ *  board with the generation before it, read off the tiles the step
+ *  changed. Both store only the non-zero bytes of the non-zero words, so
+ *  empty space costs nothing, settled debris drops out of the deltas and
+ *  a delta costs a few bytes per word that changed. When the frames
+ *  outgrow the memory budget, the oldest keyframe goes, along with the
+ *  deltas that build on it.
+ *
+ *  Seeking decodes the nearest keyframe at or before the target and
+ *  applies the deltas after it, and carries on from the last seek when
+ *  scrubbing forwards through the same stretch.
+ *
+ *  file: history.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "board.hpp"
+
+#define HS_DEFAULT_BUDGET (size_t{64} << 20)    /* bytes of frames kept */
+#define HS_DEFAULT_INTERVAL 64                  /* generations between keyframes */
+
+class History
+{
+    private:
+        struct Frame {
+            uint64_t generation;
+            bool key;
+            std::vector<uint8_t> bytes;     /* see FrameWriter */
+        };
+
+        std::deque<Frame> hs_frames;        /* oldest first, generations rising */
+        size_t hs_budget;
+        size_t hs_bytes;
+        int hs_interval;
+        bool hs_resync;                     /* the next frame must be a keyframe */
+
+        /* the board as of hs_decoded_generation, or invalid */
+        std::vector<uint64_t> hs_cells;
+        uint64_t hs_decoded_generation;
+        bool hs_decoded;
+
+        void push(Frame&&);
+        void drop_from(uint64_t);
+        void evict(void);
+        [[ nodiscard ]] size_t find(uint64_t) const;
+        void apply(Frame const&);
+
+    public:
+        explicit History(size_t budget = HS_DEFAULT_BUDGET,
+                int interval = HS_DEFAULT_INTERVAL);
+
+        void configure(size_t, int);
+        void clear(void);
+        void record(Board const&);
+        bool seek(uint64_t, Board&);
+
+        [[ nodiscard ]] bool empty(void) const { return this->hs_frames.empty(); }
+        [[ nodiscard ]] size_t bytes(void) const { return this->hs_bytes; }
+
+        [[ nodiscard ]] uint64_t oldest(void) const
+        {
+            return this->hs_frames.front().generation;
+        }
+
+        [[ nodiscard ]] uint64_t newest(void) const
+        {
+            return this->hs_frames.back().generation;
+        }
+};
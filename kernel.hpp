@@ -0,0 +1,188 @@
+/**
+ * KERNEL:
+ *  This file contains the bit-sliced cell update shared by every engine
+ *  that stores cells one bit per cell, for any Life-like rule
+ *
+ *  The kernel is a template over the word type, so the same body serves
+ *  plain 64-bit words and compiler vector types alike: every bit position
+ *  of the operands is an independent cell.
+ *
+ *  file: kernel.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "rule.hpp"
+
+/* full adder over bit-sliced operands */
+#define K_FULL_ADD(sum, carry, a, b, c) \
+    do { \
+        auto _x = (a) ^ (b); \
+        (sum) = _x ^ (c); \
+        (carry) = ((a) & (b)) | (_x & (c)); \
+    } while (0)
+
+/* a rule of K_RUNTIME takes its masks from the rule argument instead */
+#define K_RUNTIME 0xFFFFFFFFu
+
+/* the cells whose 4-bit neighbour count, as bit slices, is exactly n */
+template <typename V>
+inline void
+k_count_is(V& out, int n, V const& ones, V const& twos, V const& fours,
+        V const& eights)
+{
+    if (n == 8) {
+
+        out = eights;
+        return;
+    }
+
+    out = ((n & 1) ? ones : ~ones) & ((n & 2) ? twos : ~twos)
+        & ((n & 4) ? fours : ~fours) & ~eights;
+}
+
+/*
+ * any function of two bit slices, given as a truth table with bit a | b << 1
+ * holding f(a, b), spelled out as the fewest operations that compute it
+ */
+template <unsigned TABLE, typename V>
+inline void
+k_table2(V& out, V const& a, V const& b)
+{
+    if constexpr (TABLE == 0x0) out = a ^ a;
+    else if constexpr (TABLE == 0x1) out = ~(a | b);
+    else if constexpr (TABLE == 0x2) out = a & ~b;
+    else if constexpr (TABLE == 0x3) out = ~b;
+    else if constexpr (TABLE == 0x4) out = ~a & b;
+    else if constexpr (TABLE == 0x5) out = ~a;
+    else if constexpr (TABLE == 0x6) out = a ^ b;
+    else if constexpr (TABLE == 0x7) out = ~(a & b);
+    else if constexpr (TABLE == 0x8) out = a & b;
+    else if constexpr (TABLE == 0x9) out = ~(a ^ b);
+    else if constexpr (TABLE == 0xA) out = a;
+    else if constexpr (TABLE == 0xB) out = a | ~b;
+    else if constexpr (TABLE == 0xC) out = b;
+    else if constexpr (TABLE == 0xD) out = ~a | b;
+    else if constexpr (TABLE == 0xE) out = a | b;
+    else out = ~(a ^ a);
+}
+
+/*
+ * the next state for four consecutive neighbour counts, told apart by the
+ * low two count bits: BORN and KEPT are those counts' slices of the rule's
+ * birth and survival masks
+ */
+template <unsigned BORN, unsigned KEPT, typename V>
+inline void
+k_quad(V& out, V const& ones, V const& twos, V const& c)
+{
+    V born, kept;
+
+    if constexpr (BORN == KEPT) {
+
+        k_table2<BORN>(out, ones, twos);
+    } else if constexpr (BORN == 0) {
+
+        k_table2<KEPT>(kept, ones, twos);
+        out = c & kept;
+    } else if constexpr (KEPT == 0) {
+
+        k_table2<BORN>(born, ones, twos);
+        out = ~c & born;
+    } else {
+
+        k_table2<BORN>(born, ones, twos);
+        k_table2<KEPT>(kept, ones, twos);
+        out = born ^ (c & (born ^ kept));
+    }
+}
+
+/*
+ * operands and result are passed by reference so that wide vector types
+ * never cross a function boundary by value, whatever the caller's target
+ * features are.
+ *
+ * RULE is a Rule::bits() value. A constant rule is compiled down to just
+ * the operations its masks need: counts 0-3 and 4-7 each reduce to a
+ * function of the two low count bits and the cell, selected by the fours
+ * slice, and 8 has a slice of its own. For B3/S23 that leaves
+ * ~fours & twos & (ones | c). K_RUNTIME tests every count against the
+ * masks in rule instead.
+ */
+template <uint32_t RULE, typename V>
+inline void
+life_kernel(V& out, V const& nw, V const& n, V const& ne, V const& w,
+        V const& c, V const& e, V const& sw, V const& s, V const& se,
+        uint32_t rule = RULE)
+{
+    V s_n, c_n, s_s, c_s, s_m, c_m;
+    V ones, c_1, t_0, t_1, twos, t_2, fours, eights;
+
+    /* column sums of the rows above and below, then of the centre row */
+    K_FULL_ADD(s_n, c_n, nw, n, ne);
+    K_FULL_ADD(s_s, c_s, sw, s, se);
+    s_m = w ^ e;
+    c_m = w & e;
+
+    /* fold the partial sums into a 4-bit neighbour count per cell */
+    K_FULL_ADD(ones, c_1, s_n, s_s, s_m);
+    K_FULL_ADD(t_0, t_1, c_n, c_s, c_m);
+    twos = t_0 ^ c_1;
+    t_2 = t_0 & c_1;
+    fours = t_1 ^ t_2;
+    eights = t_1 & t_2;
+
+    if constexpr (RULE != K_RUNTIME) {
+
+        constexpr unsigned born = RULE & 0x1FF;
+        constexpr unsigned kept = RULE >> 9;
+        V low, high;
+
+        /* a count of 8 reads as 0 in the low bits, so 0 must rule it out */
+        k_quad<born & 0xF, kept & 0xF>(low, ones, twos, c);
+        if constexpr ((born | kept) & 1)
+            out = ~fours & ~eights & low;
+        else
+            out = ~fours & low;
+
+        if constexpr (((born | kept) >> 4) & 0xF) {
+
+            k_quad<(born >> 4) & 0xF, (kept >> 4) & 0xF>(high, ones, twos, c);
+            out |= fours & high;
+        }
+
+        if constexpr ((born >> 8) & (kept >> 8) & 1)
+            out |= eights;
+        else if constexpr ((born >> 8) & 1)
+            out |= eights & ~c;
+        else if constexpr ((kept >> 8) & 1)
+            out |= eights & c;
+        return;
+    }
+
+    V born = {};
+    V kept = {};
+
+    for (int count = 0; count <= 8; count++) {
+
+        bool births = (rule >> count) & 1;
+        bool survives = (rule >> (9 + count)) & 1;
+
+        if (!births && !survives)
+            continue;
+
+        V match;
+
+        k_count_is(match, count, ones, twos, fours, eights);
+        if (births)
+            born |= match;
+        if (survives)
+            kept |= match;
+    }
+
+    out = (born & ~c) | (kept & c);
+}
@@ -7,6 +7,10 @@
  */
 
 #include <memory>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 #if defined(__gnu_linux__) || defined(__linux__)
     #include <SDL2/SDL.h>
@@ -20,18 +24,173 @@
     #include <SDL2_gfxPrimitives.h>
 #endif
 
+#include "rule.hpp"
 #include "game.hpp"
+#include "history.hpp"
+#include "checkpoint.hpp"
+#include "headless.hpp"
+
+static void
+usage(char const *name)
+{
+    fprintf(stderr,
+            "usage: %s [--width W] [--height H] [--cell-size PX] [--threads N]\n"
+            "          [--rate N] [--rule RULE] [--input FILE] [--history MB]\n"
+            "          [--keyframe-interval N] [--resume FILE] [--checkpoint FILE]\n"
+            "          [--trace FILE] [--brush FILE]...\n"
+            "       %s --headless [--generations N] [--engine dense|hashlife|sparse]\n"
+            "          [--width W] [--height H] [--rule RULE] [--input FILE]\n"
+            "          [--output FILE] [--format rle|cells|mc] [--threads N]\n"
+            "          [--stop-on-cycle] [--resume FILE] [--checkpoint FILE]\n"
+            "          [--checkpoint-every N] [--shards N]\n",
+            name, name);
+}
 
 int
-main([[maybe_unused]] int argv, [[maybe_unused]] char **args)
+main(int argv, char **args)
 {
-    std::unique_ptr<Game> game = std::make_unique<Game>();
+    HeadlessOptions opts = {nullptr, nullptr, nullptr, "dense", nullptr, nullptr,
+        nullptr, 0, 0, false, G_DEFAULT_BOARD_SIZE, G_DEFAULT_BOARD_SIZE, 0, 0};
+    Checkpoint resume;
+    Rule rule = R_CONWAY;
+    bool headless = false;
+    double cell_size = 0;
+    size_t history = HS_DEFAULT_BUDGET >> 20;
+    int interval = HS_DEFAULT_INTERVAL;
+    int rate = G_DEFAULT_RATE;
+    char const *trace = nullptr;
+    std::vector<char const *> brushes;
     int rc = EXIT_SUCCESS;
 
-    rc = game->init(800, 800);
+    for (int i = 1; i < argv; i++) {
+
+        bool has_value = i + 1 < argv;
+
+        if (!strcmp(args[i], "--headless")) {
+
+            headless = true;
+        } else if (!strcmp(args[i], "--stop-on-cycle")) {
+
+            opts.stop_on_cycle = true;
+        } else if (!strcmp(args[i], "--threads") && has_value) {
+
+            opts.threads = atoi(args[++i]);
+        } else if (!strcmp(args[i], "--shards") && has_value) {
+
+            opts.shards = atoi(args[++i]);
+        } else if (!strcmp(args[i], "--generations") && has_value) {
+
+            opts.generations = strtoull(args[++i], nullptr, 10);
+        } else if (!strcmp(args[i], "--engine") && has_value) {
+
+            opts.engine = args[++i];
+        } else if (!strcmp(args[i], "--width") && has_value) {
+
+            opts.width = atoi(args[++i]);
+        } else if (!strcmp(args[i], "--height") && has_value) {
+
+            opts.height = atoi(args[++i]);
+        } else if (!strcmp(args[i], "--rate") && has_value) {
+
+            rate = atoi(args[++i]);
+        } else if (!strcmp(args[i], "--cell-size") && has_value) {
+
+            cell_size = atof(args[++i]);
+        } else if (!strcmp(args[i], "--history") && has_value) {
+
+            history = strtoull(args[++i], nullptr, 10);
+        } else if (!strcmp(args[i], "--keyframe-interval") && has_value) {
+
+            interval = atoi(args[++i]);
+        } else if (!strcmp(args[i], "--rule") && has_value) {
+
+            opts.rule = args[++i];
+        } else if (!strcmp(args[i], "--input") && has_value) {
+
+            opts.input = args[++i];
+        } else if (!strcmp(args[i], "--resume") && has_value) {
+
+            opts.resume = args[++i];
+        } else if (!strcmp(args[i], "--checkpoint") && has_value) {
+
+            opts.checkpoint = args[++i];
+        } else if (!strcmp(args[i], "--checkpoint-every") && has_value) {
+
+            opts.checkpoint_every = strtoull(args[++i], nullptr, 10);
+        } else if (!strcmp(args[i], "--brush") && has_value) {
+
+            brushes.push_back(args[++i]);
+        } else if (!strcmp(args[i], "--trace") && has_value) {
+
+            trace = args[++i];
+        } else if (!strcmp(args[i], "--output") && has_value) {
+
+            opts.output = args[++i];
+        } else if (!strcmp(args[i], "--format") && has_value) {
+
+            opts.format = args[++i];
+        } else {
+
+            usage(args[0]);
+            return (EXIT_FAILURE);
+        }
+    }
+
+    /* batch runs never touch SDL, so they work without a display */
+    if (headless)
+        return run_headless(opts);
+
+    /* a checkpoint brings its own board size */
+    if (opts.resume) {
+
+        if (resume.open(opts.resume))
+            return (EXIT_FAILURE);
+        opts.width = resume.width();
+        opts.height = resume.height();
+    }
+
+    if (opts.width <= 0 || opts.height <= 0) {
+
+        fprintf(stderr, "[ERROR] :: %s :: invalid board size %dx%d\n",
+                __func__, opts.width, opts.height);
+        return (EXIT_FAILURE);
+    }
+
+    if (opts.rule && parse_rule(opts.rule, &rule))
+        return (EXIT_FAILURE);
+
+    std::unique_ptr<Game> game = std::make_unique<Game>(opts.width,
+            opts.height, cell_size, opts.threads);
+
+    game->set_rate(rate);
+    game->set_history(history << 20, interval);
+    if (opts.checkpoint)
+        game->set_checkpoint_path(opts.checkpoint);
+    if (trace)
+        game->set_trace(trace);
+    for (char const *brush : brushes) {
+
+        if (game->add_brush(brush))
+            return (EXIT_FAILURE);
+    }
+    rc = game->init();
     if (rc)
         goto out;
 
+    if (opts.resume && game->load_checkpoint(resume)) {
+
+        rc = EXIT_FAILURE;
+        goto out;
+    }
+    if (opts.input && game->load_pattern(opts.input)) {
+
+        rc = EXIT_FAILURE;
+        goto out;
+    }
+    /* an explicit --rule overrides the one the pattern file names */
+    if (opts.rule)
+        game->set_rule(rule);
+
     game->loop();
 
 out:
@@ -0,0 +1,141 @@
+/**
+ * MAPFILE:
+ *  This file contains the read-only file mapping used by the pattern and
+ *  checkpoint readers
+ *
+ *  file: mapfile.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+#include "mapfile.hpp"
+
+MappedFile::MappedFile(void)
+{
+    this->m_data = nullptr;
+    this->m_size = 0;
+#if defined(_WIN32) || defined(__CYGWIN__)
+    this->m_file = INVALID_HANDLE_VALUE;
+    this->m_mapping = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile(void)
+{
+    this->close();
+}
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+
+int
+MappedFile::open(char const *path)
+{
+    LARGE_INTEGER size;
+
+    this->close();
+    this->m_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (this->m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(this->m_file, &size)) {
+
+        fprintf(stderr, "[ERROR] :: %s :: cannot open %s\n", __func__, path);
+        return (EXIT_FAILURE);
+    }
+
+    this->m_size = static_cast<size_t>(size.QuadPart);
+    if (!this->m_size)
+        return (EXIT_SUCCESS);
+
+    this->m_mapping = CreateFileMappingA(this->m_file, nullptr, PAGE_READONLY,
+            0, 0, nullptr);
+    if (this->m_mapping)
+        this->m_data = static_cast<char const *>(
+                MapViewOfFile(this->m_mapping, FILE_MAP_READ, 0, 0, 0));
+
+    if (!this->m_data) {
+
+        fprintf(stderr, "[ERROR] :: %s :: cannot map %s\n", __func__, path);
+        this->close();
+        return (EXIT_FAILURE);
+    }
+
+    return (EXIT_SUCCESS);
+}
+
+void
+MappedFile::close(void)
+{
+    if (this->m_data)
+        UnmapViewOfFile(this->m_data);
+    if (this->m_mapping)
+        CloseHandle(this->m_mapping);
+    if (this->m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(this->m_file);
+
+    this->m_data = nullptr;
+    this->m_size = 0;
+    this->m_file = INVALID_HANDLE_VALUE;
+    this->m_mapping = nullptr;
+}
+
+#else
+
+int
+MappedFile::open(char const *path)
+{
+    struct stat st;
+    int fd;
+
+    this->close();
+    if (fd = ::open(path, O_RDONLY), fd < 0 || fstat(fd, &st)) {
+
+        fprintf(stderr, "[ERROR] :: %s :: cannot open %s\n", __func__, path);
+        if (fd >= 0)
+            ::close(fd);
+        return (EXIT_FAILURE);
+    }
+
+    this->m_size = static_cast<size_t>(st.st_size);
+    if (this->m_size) {
+
+        void *data = mmap(nullptr, this->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED) {
+
+            fprintf(stderr, "[ERROR] :: %s :: cannot map %s\n", __func__, path);
+            ::close(fd);
+            this->m_size = 0;
+            return (EXIT_FAILURE);
+        }
+
+        /* parsers walk the file front to back exactly once */
+        madvise(data, this->m_size, MADV_SEQUENTIAL);
+        this->m_data = static_cast<char const *>(data);
+    }
+
+    ::close(fd);
+    return (EXIT_SUCCESS);
+}
+
+void
+MappedFile::close(void)
+{
+    if (this->m_data)
+        munmap(const_cast<char *>(this->m_data), this->m_size);
+
+    this->m_data = nullptr;
+    this->m_size = 0;
+}
+
+#endif
@@ -0,0 +1,39 @@
+/**
+ * MAPFILE:
+ *  This file contains all prototypes and utilities needed to map a file
+ *  read-only into memory, so large inputs can be parsed in place without
+ *  being copied through stdio buffers first
+ *
+ *  file: mapfile.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <cstddef>
+
+class MappedFile
+{
+    private:
+        char const *m_data;
+        size_t m_size;
+#if defined(_WIN32) || defined(__CYGWIN__)
+        void *m_file;
+        void *m_mapping;
+#endif
+
+        void close(void);
+
+    public:
+        MappedFile(void);
+        ~MappedFile(void);
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+
+        int open(char const *);
+
+        [[ nodiscard ]] char const *data(void) const { return this->m_data; }
+        [[ nodiscard ]] size_t size(void) const { return this->m_size; }
+};
@@ -0,0 +1,848 @@
+/**
+ * PATTERN:
+ *  This file contains the pattern file readers and writers
+ *
+ *  All three readers run over a read-only mapping of the whole file and
+ *  decode it in a single pass, handing each run of live cells to the sink
+ *  as soon as it is complete.
+ *
+ *  file: pattern.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <bit>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "rule.hpp"
+#include "board.hpp"
+#include "mapfile.hpp"
+#include "pattern.hpp"
+#include "hashlife.hpp"
+
+/* RLE writers keep their lines inside this many characters */
+#define P_RLE_LINE 70
+
+/*
+ * no number read, and no RLE coordinate, may pass this, so sums of two
+ * of them can never overflow an int64_t
+ */
+#define P_MAX_NUMBER (int64_t{1} << 62)
+
+static inline char const *
+line_end(char const *p, char const *end)
+{
+    char const *nl = static_cast<char const *>(memchr(p, '\n', end - p));
+
+    return (nl) ? (nl) : (end);
+}
+
+static inline bool
+is_space(char c)
+{
+    return (c == ' ' || c == '\t' || c == '\r');
+}
+
+/*
+ * reads a signed decimal, stopping at end rather than at a terminator;
+ * one past P_MAX_NUMBER is an error
+ */
+static bool
+read_int(char const **p, char const *end, int64_t *out)
+{
+    char const *q = *p;
+    bool negative = false;
+    int64_t v = 0;
+
+    while (q < end && is_space(*q))
+        q++;
+    if (q < end && (*q == '-' || *q == '+'))
+        negative = (*q++ == '-');
+    if (q == end || *q < '0' || *q > '9')
+        return (false);
+
+    while (q < end && *q >= '0' && *q <= '9') {
+
+        if (v > (P_MAX_NUMBER - (*q - '0')) / 10) {
+
+            fprintf(stderr, "[ERROR] :: %s :: number over %lld\n", __func__,
+                    static_cast<long long>(P_MAX_NUMBER));
+            return (false);
+        }
+        v = v * 10 + (*q++ - '0');
+    }
+
+    *out = (negative) ? -v : v;
+    *p = q;
+    return (true);
+}
+
+static PatternFormat
+sniff_format(char const *p, char const *end)
+{
+    while (p < end && (is_space(*p) || *p == '\n'))
+        p++;
+
+    if (end - p >= 4 && !memcmp(p, "[M2]", 4))
+        return (P_MACROCELL);
+
+    /* RLE is the only format whose first real line is an x = header */
+    for (char const *eol; p < end; p = eol + 1) {
+
+        eol = line_end(p, end);
+        if (*p == '#')
+            continue;
+        if (*p == '!')
+            return (P_PLAINTEXT);
+
+        char const *q = p;
+        if (*q++ != 'x')
+            return (P_PLAINTEXT);
+        while (q < eol && is_space(*q))
+            q++;
+        return (q < eol && *q == '=') ? (P_RLE) : (P_PLAINTEXT);
+    }
+
+    return (P_PLAINTEXT);
+}
+
+/*
+ * plaintext (.cells): '!' starts a comment line, 'O' or '*' is a live
+ * cell and anything else on a row is dead
+ */
+static int
+read_plaintext(char const *p, char const *end, PatternSink& sink,
+        PatternInfo *info)
+{
+    int64_t y = 0;
+    int64_t width = 0;
+
+    for (char const *eol; p < end; p = eol + 1) {
+
+        eol = line_end(p, end);
+        if (*p == '!')
+            continue;
+
+        int64_t x = 0;
+        int64_t run = 0;
+
+        for (char const *c = p; c < eol; c++) {
+
+            if (*c == '\r')
+                continue;
+
+            if (*c == 'O' || *c == '*') {
+
+                run++;
+            } else if (run) {
+
+                sink.set_run(x - run, y, run);
+                run = 0;
+            }
+            x++;
+        }
+
+        if (run)
+            sink.set_run(x - run, y, run);
+        width = std::max(width, x);
+        y++;
+    }
+
+    info->width = width;
+    info->height = y;
+    return (EXIT_SUCCESS);
+}
+
+/* picks the rule and the fields we use out of an "x = 3, y = 3, ..." line */
+static void
+read_rle_header(char const *p, char const *eol, PatternInfo *info)
+{
+    while (p < eol) {
+
+        while (p < eol && (is_space(*p) || *p == ','))
+            p++;
+
+        char const *key = p;
+        while (p < eol && !is_space(*p) && *p != '=')
+            p++;
+        size_t key_len = p - key;
+
+        while (p < eol && (is_space(*p) || *p == '='))
+            p++;
+
+        char const *value = p;
+        while (p < eol && *p != ',')
+            p++;
+        char const *value_end = p;
+        while (value_end > value && is_space(value_end[-1]))
+            value_end--;
+
+        if (key_len == 1 && *key == 'x')
+            read_int(&value, value_end, &info->width);
+        else if (key_len == 1 && *key == 'y')
+            read_int(&value, value_end, &info->height);
+        else if (key_len == 4 && !memcmp(key, "rule", 4))
+            info->rule.assign(value, value_end);
+    }
+}
+
+/*
+ * RLE: '#' comment lines, an "x = w, y = h, rule = r" header, then runs of
+ * 'b' (dead) and 'o' (alive) separated by '$' and ended by '!'. Golly's
+ * "#CXRLE Pos=x,y" comment moves the pattern's top-left corner.
+ */
+static int
+read_rle(char const *p, char const *end, PatternSink& sink, PatternInfo *info)
+{
+    int64_t x0 = 0;
+    int64_t y0 = 0;
+
+    for (char const *eol; p < end; p = eol + 1) {
+
+        eol = line_end(p, end);
+        if (*p == '#') {
+
+            if (eol - p > 6 && !memcmp(p, "#CXRLE", 6)) {
+
+                char const *pos = p + 6;
+
+                while (pos + 4 <= eol && memcmp(pos, "Pos=", 4))
+                    pos++;
+                if (pos + 4 <= eol) {
+
+                    pos += 4;
+                    if (read_int(&pos, eol, &x0) && pos < eol && *pos == ',') {
+
+                        pos++;
+                        read_int(&pos, eol, &y0);
+                    }
+                }
+            } else if (eol - p > 2 && p[1] == 'r') {
+
+                char const *rule = p + 2;
+                char const *rule_end = eol;
+
+                while (rule < rule_end && is_space(*rule))
+                    rule++;
+                while (rule_end > rule && is_space(rule_end[-1]))
+                    rule_end--;
+                info->rule.assign(rule, rule_end);
+            }
+            continue;
+        }
+
+        read_rle_header(p, eol, info);
+        p = eol + 1;
+        break;
+    }
+
+    int64_t x = 0;
+    int64_t y = 0;
+    int64_t count = 0;
+
+    for (; p < end; p++) {
+
+        char c = *p;
+
+        if (c >= '0' && c <= '9') {
+
+            if (count > (P_MAX_NUMBER - (c - '0')) / 10) {
+
+                fprintf(stderr, "[ERROR] :: %s :: run count over %lld\n",
+                        __func__, static_cast<long long>(P_MAX_NUMBER));
+                return (EXIT_FAILURE);
+            }
+            count = count * 10 + (c - '0');
+            continue;
+        }
+
+        int64_t n = (count) ? (count) : (1);
+        bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        count = 0;
+
+        if (((letter || c == '.') && n > P_MAX_NUMBER - x)
+                || (c == '$' && n > P_MAX_NUMBER - y)) {
+
+            fprintf(stderr, "[ERROR] :: %s :: RLE body reaches past %lld\n",
+                    __func__, static_cast<long long>(P_MAX_NUMBER));
+            return (EXIT_FAILURE);
+        }
+
+        if (c == '!') {
+
+            break;
+        } else if (c == '$') {
+
+            x = 0;
+            y += n;
+        } else if (c == 'b' || c == '.') {
+
+            x += n;
+        } else if (letter) {
+
+            /* any other state letter is treated as alive */
+            sink.set_run(x0 + x, y0 + y, n);
+            x += n;
+        } else if (c == '#') {
+
+            p = line_end(p, end);
+        } else if (!is_space(c) && c != '\n') {
+
+            fprintf(stderr, "[ERROR] :: %s :: unexpected '%c' in RLE body\n",
+                    __func__, c);
+            return (EXIT_FAILURE);
+        }
+    }
+
+    return (EXIT_SUCCESS);
+}
+
+/* expands one Macrocell node into runs, with its top-left corner at (x, y) */
+static void
+emit_node(std::vector<MacroNode> const& nodes, uint32_t index, int64_t x,
+        int64_t y, PatternSink& sink)
+{
+    MacroNode const& node = nodes[index - 1];
+
+    if (node.level == 3) {
+
+        for (int r = 0; r < 8; r++) {
+
+            uint64_t row = (node.leaf >> (r * 8)) & 0xff;
+
+            while (row) {
+
+                int start = std::countr_zero(row);
+                int len = std::countr_one(row >> start);
+
+                sink.set_run(x + start, y + r, len);
+                row &= ~(((uint64_t{1} << len) - 1) << start);
+            }
+        }
+        return;
+    }
+
+    int64_t h = int64_t{1} << (node.level - 1);
+    int64_t ox[4] = {0, h, 0, h};
+    int64_t oy[4] = {0, 0, h, h};
+
+    for (int q = 0; q < 4; q++) {
+
+        if (node.child[q])
+            emit_node(nodes, node.child[q], x + ox[q], y + oy[q], sink);
+    }
+}
+
+/*
+ * Macrocell (.mc): after the "[M2]" line, every non-comment line defines
+ * the next node, numbered from 1. Leaves are 8x8 squares drawn with '.',
+ * '*' and '$'; larger nodes are "level nw ne sw se", where 0 is empty.
+ * The last node is the root, which is centred on the origin.
+ */
+static int
+read_macrocell(char const *p, char const *end, PatternSink& sink,
+        PatternInfo *info)
+{
+    std::vector<MacroNode> nodes;
+
+    p = line_end(p, end) + 1;
+    for (char const *eol; p < end; p = eol + 1) {
+
+        eol = line_end(p, end);
+        if (*p == '#') {
+
+            if (eol - p > 2 && p[1] == 'R') {
+
+                char const *rule = p + 2;
+                char const *rule_end = eol;
+
+                while (rule < rule_end && is_space(*rule))
+                    rule++;
+                while (rule_end > rule && is_space(rule_end[-1]))
+                    rule_end--;
+                info->rule.assign(rule, rule_end);
+            }
+            continue;
+        }
+
+        if (*p == '.' || *p == '*' || *p == '$') {
+
+            MacroNode leaf = {3, {0, 0, 0, 0}, 0};
+            int x = 0;
+            int y = 0;
+
+            for (char const *c = p; c < eol && !is_space(*c); c++) {
+
+                if (*c == '$') {
+
+                    x = 0;
+                    y++;
+                    continue;
+                }
+                if (x > 7 || y > 7) {
+
+                    fprintf(stderr, "[ERROR] :: %s :: leaf %zu overflows 8x8\n",
+                            __func__, nodes.size() + 1);
+                    return (EXIT_FAILURE);
+                }
+                if (*c == '*')
+                    leaf.leaf |= uint64_t{1} << (y * 8 + x);
+                x++;
+            }
+            nodes.push_back(leaf);
+            continue;
+        }
+
+        MacroNode node = {0, {0, 0, 0, 0}, 0};
+        int64_t v;
+        char const *q = p;
+
+        if (!read_int(&q, eol, &v)) {
+
+            if (q < eol && !is_space(*q))
+                goto malformed;
+            continue;       /* blank line */
+        }
+        node.level = static_cast<int>(v);
+        if (node.level < 4 || node.level > 63)
+            goto malformed;
+
+        for (int c = 0; c < 4; c++) {
+
+            if (!read_int(&q, eol, &v) || v < 0
+                    || static_cast<uint64_t>(v) > nodes.size())
+                goto malformed;
+            if (v && nodes[v - 1].level != node.level - 1)
+                goto malformed;
+            node.child[c] = static_cast<uint32_t>(v);
+        }
+        nodes.push_back(node);
+    }
+
+    if (nodes.empty())
+        return (EXIT_SUCCESS);
+
+    info->width = int64_t{1} << nodes.back().level;
+    info->height = info->width;
+
+    if (!sink.set_tree(nodes))
+        emit_node(nodes, static_cast<uint32_t>(nodes.size()),
+                -(info->width / 2), -(info->height / 2), sink);
+
+    return (EXIT_SUCCESS);
+
+malformed:
+    fprintf(stderr, "[ERROR] :: %s :: malformed node %zu\n", __func__,
+            nodes.size() + 1);
+    return (EXIT_FAILURE);
+}
+
+/* loads an RLE, plaintext or Macrocell file, telling them apart by content */
+int
+read_pattern(char const *path, PatternSink& sink, PatternInfo *info)
+{
+    MappedFile file;
+
+    if (file.open(path))
+        return (EXIT_FAILURE);
+
+    return read_pattern_text(file.data(), file.size(), sink, info);
+}
+
+/* the same, for a pattern already in memory */
+int
+read_pattern_text(char const *text, size_t size, PatternSink& sink,
+        PatternInfo *info)
+{
+    PatternInfo local;
+    char const *p = text;
+    char const *end = p + size;
+
+    if (!info)
+        info = &local;
+
+    *info = PatternInfo{sniff_format(p, end), 0, 0, ""};
+    switch (info->format) {
+        case P_RLE:
+            return read_rle(p, end, sink, info);
+        case P_MACROCELL:
+            return read_macrocell(p, end, sink, info);
+        case P_PLAINTEXT:
+            break;
+    }
+
+    return read_plaintext(p, end, sink, info);
+}
+
+static void
+write_comments(FILE *out, char const *prefix, char const *comments)
+{
+    if (!comments)
+        return;
+
+    while (*comments) {
+
+        char const *nl = strchr(comments, '\n');
+        int len = (nl) ? static_cast<int>(nl - comments)
+                       : static_cast<int>(strlen(comments));
+
+        fprintf(out, "%s%.*s\n", prefix, len, comments);
+        comments += len + (nl != nullptr);
+    }
+}
+
+/* finds the next run of live cells at or after x, returning its length */
+static int
+next_run(uint64_t const *row, int words, int *x)
+{
+    int i = *x >> 6;
+    uint64_t w = (i < words) ? row[i] & (~uint64_t{0} << (*x & 63)) : 0;
+
+    while (!w && ++i < words)
+        w = row[i];
+    if (!w)
+        return (0);
+
+    int start = i * 64 + std::countr_zero(w);
+    int stop = start;
+
+    /* the run ends at the first dead cell, which may be words away */
+    w = ~row[i] & (~uint64_t{0} << (start & 63));
+    while (!w && ++i < words)
+        w = ~row[i];
+    stop = (w) ? i * 64 + std::countr_zero(w) : words * 64;
+
+    *x = start;
+    return (stop - start);
+}
+
+/* writes rows y0 to y1 - 1 of board as plaintext, without comments */
+int
+write_plaintext_rows(FILE *out, Board const& board, int y0, int y1)
+{
+    std::vector<char> line(board.width() + 1);
+
+    /* rows are built in memory and written whole */
+    for (int y = y0; y < y1; y++) {
+
+        uint64_t const *row = board.row(y);
+        int x = 0;
+        int len;
+
+        /* trailing dead cells are left off each row */
+        for (int at = 0; (len = next_run(row, board.words(), &at)); at += len) {
+
+            for (; x < at; x++)
+                line[x] = '.';
+            for (; x < at + len; x++)
+                line[x] = 'O';
+        }
+        line[x++] = '\n';
+        fwrite(line.data(), 1, x, out);
+    }
+
+    return (ferror(out) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+int
+write_plaintext(FILE *out, Board const& board, char const *comments)
+{
+    write_comments(out, "!", comments);
+    return write_plaintext_rows(out, board, 0, board.height());
+}
+
+/* one line of RLE output, written out whole once the next token won't fit */
+struct RleLine {
+    char buf[P_RLE_LINE + 1];
+    int len;
+};
+
+static void
+rle_token(FILE *out, RleLine *line, int64_t count, char tag)
+{
+    char digits[24];
+    int n = 0;
+
+    if (count > 1) {
+
+        for (; count; count /= 10)
+            digits[n++] = static_cast<char>('0' + count % 10);
+    }
+
+    if (line->len + n + 1 > P_RLE_LINE) {
+
+        line->buf[line->len++] = '\n';
+        fwrite(line->buf, 1, line->len, out);
+        line->len = 0;
+    }
+    while (n)
+        line->buf[line->len++] = digits[--n];
+    line->buf[line->len++] = tag;
+}
+
+/*
+ * hands token the runs of rows y0 to y1 - 1 of board; blank rows fold
+ * into the count of the next row break, and rows carries that count from
+ * one call to the next
+ */
+template <typename F>
+static void
+rle_rows(Board const& board, int y0, int y1, int64_t *rows, F&& token)
+{
+    for (int y = y0; y < y1; y++) {
+
+        uint64_t const *row = board.row(y);
+        int x = 0;
+        int len;
+
+        for (int at = 0; (len = next_run(row, board.words(), &at)); at += len) {
+
+            if (*rows) {
+
+                token(*rows, '$');
+                *rows = 0;
+            }
+            if (at > x)
+                token(at - x, 'b');
+            token(len, 'o');
+            x = at + len;
+        }
+        ++*rows;
+    }
+}
+
+int
+write_rle(FILE *out, Board const& board, char const *comments)
+{
+    RleLine line = {{}, 0};
+    int64_t rows = 0;
+
+    write_comments(out, "#C ", comments);
+    fprintf(out, "x = %d, y = %d, rule = %s\n", board.width(), board.height(),
+            rule_string(board.rule()).c_str());
+
+    rle_rows(board, 0, board.height(), &rows, [&](int64_t count, char tag) {
+        rle_token(out, &line, count, tag);
+    });
+
+    rle_token(out, &line, 1, '!');
+    line.buf[line.len++] = '\n';
+    fwrite(line.buf, 1, line.len, out);
+    return (ferror(out) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+/*
+ * writes rows y0 to y1 - 1 of board as bare RLE tokens, on one line and
+ * ending with a row break for every row after the last run, to be put
+ * together with the rows around them by write_rle_parts
+ */
+int
+write_rle_rows(FILE *out, Board const& board, int y0, int y1)
+{
+    int64_t rows = 0;
+    auto token = [out](int64_t count, char tag) {
+
+        if (count > 1)
+            fprintf(out, "%lld", static_cast<long long>(count));
+        fputc(tag, out);
+    };
+
+    rle_rows(board, y0, y1, &rows, token);
+    if (rows)
+        token(rows, '$');
+
+    return (ferror(out) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+/* copies part, from its start, to the end of out */
+static int
+copy_part(FILE *out, FILE *part)
+{
+    char buf[1 << 16];
+    size_t n;
+
+    rewind(part);
+    while ((n = fread(buf, 1, sizeof(buf), part)))
+        fwrite(buf, 1, n, out);
+
+    return (ferror(part) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+/* writes a board whose rows were written in bands, in order, to parts */
+int
+write_plaintext_parts(FILE *out, std::vector<FILE *> const& parts,
+        char const *comments)
+{
+    write_comments(out, "!", comments);
+    for (FILE *part : parts) {
+
+        if (copy_part(out, part))
+            return (EXIT_FAILURE);
+    }
+
+    return (ferror(out) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+/*
+ * the same for RLE: the bands' tokens are read back and broken into lines
+ * afresh, with the row breaks either side of each join made one, so the
+ * file is the one write_rle would have written for the whole board
+ */
+int
+write_rle_parts(FILE *out, std::vector<FILE *> const& parts, int width,
+        int height, Rule const& rule, char const *comments)
+{
+    RleLine line = {{}, 0};
+    int64_t rows = 0;
+    int64_t count = 0;
+    int c;
+
+    write_comments(out, "#C ", comments);
+    fprintf(out, "x = %d, y = %d, rule = %s\n", width, height,
+            rule_string(rule).c_str());
+
+    for (FILE *part : parts) {
+
+        rewind(part);
+        while ((c = getc(part)) != EOF) {
+
+            if (c >= '0' && c <= '9') {
+
+                count = count * 10 + (c - '0');
+                continue;
+            }
+
+            count = (count) ? count : 1;
+            if (c == '$') {
+
+                rows += count;
+            } else {
+
+                if (rows)
+                    rle_token(out, &line, rows, '$');
+                rle_token(out, &line, count, static_cast<char>(c));
+                rows = 0;
+            }
+            count = 0;
+        }
+        if (ferror(part))
+            return (EXIT_FAILURE);
+    }
+
+    rle_token(out, &line, 1, '!');
+    line.buf[line.len++] = '\n';
+    fwrite(line.buf, 1, line.len, out);
+    return (ferror(out) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+/* count copies of c, without a line buffer as wide as the box */
+static void
+put_repeated(FILE *out, char c, int64_t count)
+{
+    char buf[256];
+
+    memset(buf, c, sizeof(buf));
+    for (; count > 0; count -= static_cast<int64_t>(sizeof(buf)))
+        fwrite(buf, 1, static_cast<size_t>(std::min<int64_t>(count, sizeof(buf))), out);
+}
+
+int
+write_plaintext(FILE *out, std::vector<PatternCell> const& cells,
+        int64_t height, char const *comments)
+{
+    size_t i = 0;
+
+    write_comments(out, "!", comments);
+
+    for (int64_t y = 0; y < height; y++) {
+
+        int64_t x = 0;
+
+        for (; i < cells.size() && cells[i].y == y; i++) {
+
+            put_repeated(out, '.', cells[i].x - x);
+            fputc('O', out);
+            x = cells[i].x + 1;
+        }
+        fputc('\n', out);
+    }
+
+    return (ferror(out) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+int
+write_rle(FILE *out, std::vector<PatternCell> const& cells, int64_t width,
+        int64_t height, Rule const& rule, char const *comments)
+{
+    RleLine line = {{}, 0};
+    int64_t x = 0;
+    int64_t y = 0;
+
+    write_comments(out, "#C ", comments);
+    fprintf(out, "x = %lld, y = %lld, rule = %s\n",
+            static_cast<long long>(width), static_cast<long long>(height),
+            rule_string(rule).c_str());
+
+    for (size_t i = 0, j; i < cells.size(); i = j) {
+
+        /* cells side by side in one row make one run */
+        for (j = i + 1; j < cells.size() && cells[j].y == cells[i].y
+                && cells[j].x == cells[j - 1].x + 1; j++)
+            ;
+
+        if (cells[i].y > y) {
+
+            rle_token(out, &line, cells[i].y - y, '$');
+            y = cells[i].y;
+            x = 0;
+        }
+        if (cells[i].x > x)
+            rle_token(out, &line, cells[i].x - x, 'b');
+        rle_token(out, &line, static_cast<int64_t>(j - i), 'o');
+        x = cells[j - 1].x + 1;
+    }
+
+    rle_token(out, &line, 1, '!');
+    line.buf[line.len++] = '\n';
+    fwrite(line.buf, 1, line.len, out);
+    return (ferror(out) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+int
+write_macrocell(FILE *out, HashLife const& life, char const *comments)
+{
+    fprintf(out, "[M2] (cgol)\n#R %s\n", rule_string(life.rule()).c_str());
+    write_comments(out, "#C ", comments);
+
+    for (MacroNode const& node : life.export_tree()) {
+
+        if (node.level != 3) {
+
+            fprintf(out, "%d %u %u %u %u\n", node.level, node.child[0],
+                    node.child[1], node.child[2], node.child[3]);
+            continue;
+        }
+
+        /* trailing dead cells and trailing empty rows are left off */
+        int rows = 8;
+        while (rows && !((node.leaf >> ((rows - 1) * 8)) & 0xff))
+            rows--;
+
+        for (int y = 0; y < rows; y++) {
+
+            uint64_t row = (node.leaf >> (y * 8)) & 0xff;
+
+            for (int x = 0; row >> x; x++)
+                fputc(((row >> x) & 1) ? '*' : '.', out);
+            fputc('$', out);
+        }
+        fputc('\n', out);
+    }
+
+    return (ferror(out) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
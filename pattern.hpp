@@ -0,0 +1,162 @@
+/**
+ * PATTERN:
+ *  This file contains all prototypes and utilities needed to read and write
+ *  Game of Life pattern files in the RLE, plaintext (.cells) and Macrocell
+ *  (.mc) formats
+ *
+ *  Readers never build a list of cells: the input is mapped into memory and
+ *  every horizontal run of live cells they decode goes straight to a
+ *  PatternSink, which writes it into whichever engine is being loaded.
+ *  Macrocell trees can instead be handed over whole to an engine that
+ *  understands them.
+ *
+ *  file: pattern.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+#include "board.hpp"
+#include "hashlife.hpp"
+
+enum PatternFormat {
+    P_PLAINTEXT,
+    P_RLE,
+    P_MACROCELL,
+};
+
+/* a live cell of an engine with no board to write from */
+struct PatternCell {
+    int64_t x;
+    int64_t y;
+};
+
+/* what a pattern file says about itself, filled in as far as it is known */
+struct PatternInfo {
+    PatternFormat format;
+    int64_t width;              /* 0 when the file does not say */
+    int64_t height;
+    std::string rule;           /* e.g. "B3/S23", empty when unspecified */
+};
+
+class PatternSink
+{
+    public:
+        virtual ~PatternSink(void) = default;
+
+        /* brings count cells to life running east from (x, y) */
+        virtual void set_run(int64_t, int64_t, int64_t) = 0;
+
+        /*
+         * offered a whole Macrocell tree before it is expanded into runs;
+         * returns true if the tree was taken as is
+         */
+        virtual bool set_tree(std::vector<MacroNode> const&) { return (false); }
+};
+
+/* loads into a dense board, wrapping anything outside it onto the torus */
+class BoardSink : public PatternSink
+{
+    private:
+        Board& s_board;
+
+    public:
+        explicit BoardSink(Board& board) : s_board(board) {}
+
+        void set_run(int64_t x, int64_t y, int64_t count) override
+        {
+            int64_t width = this->s_board.width();
+            int64_t height = this->s_board.height();
+
+            x %= width;
+            y %= height;
+            if (x < 0)
+                x += width;
+            if (y < 0)
+                y += height;
+            count = std::min(count, width);
+
+            while (count > 0) {
+
+                int64_t span = std::min(count, width - x);
+
+                this->s_board.set_run(static_cast<int>(x), static_cast<int>(y),
+                        static_cast<int>(span));
+                x = 0;
+                count -= span;
+            }
+        }
+};
+
+/*
+ * loads into any engine with a set_cell(x, y, alive) member, using its
+ * set_run and import_tree members instead when it has them
+ */
+template <typename E>
+class EngineSink : public PatternSink
+{
+    private:
+        E& s_engine;
+
+    public:
+        explicit EngineSink(E& engine) : s_engine(engine) {}
+
+        void set_run(int64_t x, int64_t y, int64_t count) override
+        {
+            if constexpr (requires { this->s_engine.set_run(x, y, count); }) {
+
+                this->s_engine.set_run(x, y, count);
+            } else {
+
+                for (int64_t i = 0; i < count; i++)
+                    this->s_engine.set_cell(x + i, y, true);
+            }
+        }
+
+        bool set_tree(std::vector<MacroNode> const& nodes) override
+        {
+            if constexpr (requires { this->s_engine.import_tree(nodes); }) {
+
+                this->s_engine.import_tree(nodes);
+                return (true);
+            }
+            return (false);
+        }
+};
+
+int read_pattern(char const *, PatternSink&, PatternInfo * = nullptr);
+int read_pattern_text(char const *, size_t, PatternSink&, PatternInfo * = nullptr);
+
+/* comments are newline separated and may be nullptr */
+int write_plaintext(FILE *, Board const&, char const * = nullptr);
+int write_rle(FILE *, Board const&, char const * = nullptr);
+int write_macrocell(FILE *, HashLife const&, char const * = nullptr);
+
+/*
+ * the same in bands, for a board no one process holds: each band's rows
+ * are written to a part of their own, and the parts are then put together
+ * in order into the file the writers above would have written
+ */
+int write_plaintext_rows(FILE *, Board const&, int, int);
+int write_rle_rows(FILE *, Board const&, int, int);
+int write_plaintext_parts(FILE *, std::vector<FILE *> const&, char const * = nullptr);
+int write_rle_parts(FILE *, std::vector<FILE *> const&, int, int, Rule const&,
+        char const * = nullptr);
+
+/*
+ * the same, from live cells sorted by row and then column, all inside a
+ * width x height box with its corner at the origin; memory follows the
+ * cells, not the box
+ */
+int write_plaintext(FILE *, std::vector<PatternCell> const&, int64_t,
+        char const * = nullptr);
+int write_rle(FILE *, std::vector<PatternCell> const&, int64_t, int64_t,
+        Rule const&, char const * = nullptr);
@@ -0,0 +1,297 @@
+/**
+ * PROFILE:
+ *  This file contains the frame and step profiler and its trace writers
+ *
+ *  file: profile.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "profile.hpp"
+
+static char const *const zone_names[PF_ZONES] = {
+    "wait",
+    "events",
+    "display",
+    "mouse",
+    "overlay",
+    "present",
+    "step",
+    "history",
+    "publish",
+};
+
+/*
+ * zones kept as events in a trace. Waits come several to a frame and show
+ * anyway as the gaps between frames, and the history is recorded once a
+ * generation, which at full speed would fill PF_MAX_EVENTS in seconds;
+ * both are still in the totals
+ */
+static bool const zone_traced[PF_ZONES] = {
+    false,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    false,
+    true,
+};
+
+static char const *const thread_names[PF_THREADS] = {
+    "render",
+    "sim",
+};
+
+char const *
+profile_zone_name(ProfileZone zone)
+{
+    return (zone_names[zone]);
+}
+
+static ProfileThread
+zone_thread(ProfileZone zone)
+{
+    return (zone < PF_STEP) ? PF_RENDER_THREAD : PF_SIM_THREAD;
+}
+
+Profiler::Profiler(void)
+    : pf_enabled(false)
+{
+    this->pf_overlay = false;
+    this->pf_tracing = false;
+    this->pf_epoch = Clock::now();
+    for (Thread& thread : this->pf_threads) {
+
+        memset(thread.seconds, 0, sizeof(thread.seconds));
+        thread.dropped = 0;
+    }
+    this->pf_last = {};
+    this->pf_sum = {};
+    this->pf_window_frames = 0;
+    this->pf_window_start = -1;
+    this->pf_window_generation = 0;
+    memset(this->pf_average, 0, sizeof(this->pf_average));
+    this->pf_fps = 0;
+    this->pf_rate = 0;
+}
+
+/* the timers run while either the overlay is up or a trace is being kept */
+void
+Profiler::set_overlay(bool overlay)
+{
+    this->pf_overlay = overlay;
+    this->pf_enabled.store(this->pf_overlay || this->pf_tracing,
+            std::memory_order_relaxed);
+}
+
+/* only before the threads being profiled start */
+void
+Profiler::set_tracing(bool tracing)
+{
+    this->pf_tracing = tracing;
+    this->pf_enabled.store(this->pf_overlay || this->pf_tracing,
+            std::memory_order_relaxed);
+}
+
+double
+Profiler::now(void) const
+{
+    std::chrono::duration<double> elapsed = Clock::now() - this->pf_epoch;
+
+    return (elapsed.count());
+}
+
+/* called on zone's own thread, by ProfileScope */
+void
+Profiler::add(ProfileZone zone, Clock::time_point start, Clock::time_point end)
+{
+    Thread& thread = this->pf_threads[zone_thread(zone)];
+    std::chrono::duration<double> elapsed = end - start;
+
+    thread.seconds[zone] += elapsed.count();
+    if (!this->pf_tracing || !zone_traced[zone])
+        return;
+    if (thread.events.size() >= PF_MAX_EVENTS) {
+
+        thread.dropped++;
+        return;
+    }
+
+    thread.events.push_back({
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                start - this->pf_epoch).count(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+        zone,
+    });
+}
+
+/* seconds spent in zone since the last take; on zone's own thread */
+double
+Profiler::take(ProfileZone zone)
+{
+    Thread& thread = this->pf_threads[zone_thread(zone)];
+    double seconds = thread.seconds[zone];
+
+    thread.seconds[zone] = 0;
+    return (seconds);
+}
+
+/*
+ * adds a finished frame; render thread only. The overlay's figures are
+ * averaged over PF_AVERAGE_PERIOD, as single frames jitter too much to read
+ */
+void
+Profiler::frame(ProfileFrame const& frame)
+{
+    this->pf_last = frame;
+    if (this->pf_tracing && this->pf_frames.size() < PF_MAX_EVENTS)
+        this->pf_frames.push_back(frame);
+
+    if (this->pf_window_start < 0) {
+
+        this->pf_window_start = frame.time;
+        this->pf_window_generation = frame.generation;
+        return;
+    }
+
+    for (int z = 0; z < PF_ZONES; z++)
+        this->pf_sum.seconds[z] += frame.seconds[z];
+    this->pf_window_frames++;
+
+    double span = frame.time - this->pf_window_start;
+
+    if (span < PF_AVERAGE_PERIOD)
+        return;
+
+    for (int z = 0; z < PF_ZONES; z++)
+        this->pf_average[z] = this->pf_sum.seconds[z] / this->pf_window_frames;
+    this->pf_fps = this->pf_window_frames / span;
+    this->pf_rate = (frame.generation >= this->pf_window_generation)
+        ? (frame.generation - this->pf_window_generation) / span : 0;
+
+    this->pf_sum = {};
+    this->pf_window_frames = 0;
+    this->pf_window_start = frame.time;
+    this->pf_window_generation = frame.generation;
+}
+
+/*
+ * Chrome's trace event format, which chrome://tracing and Perfetto open:
+ * a complete event for every timed zone, on a track per thread, and
+ * counter tracks for the board and the draw calls of every frame
+ */
+int
+Profiler::write_trace(FILE *out) const
+{
+    char const *sep = "";
+
+    fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    for (int t = 0; t < PF_THREADS; t++) {
+
+        fprintf(out, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+                "\"tid\": %d, \"args\": {\"name\": \"%s\"}}", sep, t,
+                thread_names[t]);
+        sep = ",\n";
+    }
+
+    for (int t = 0; t < PF_THREADS; t++) {
+
+        for (Event const& event : this->pf_threads[t].events)
+            fprintf(out, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, "
+                    "\"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                    zone_names[event.zone], t, event.start / 1e3,
+                    event.duration / 1e3);
+    }
+
+    for (ProfileFrame const& frame : this->pf_frames) {
+
+        fprintf(out, ",\n{\"name\": \"board\", \"ph\": \"C\", \"pid\": 1, "
+                "\"tid\": %d, \"ts\": %.3f, \"args\": {\"population\": %llu, "
+                "\"births\": %llu, \"deaths\": %llu}}", PF_RENDER_THREAD,
+                frame.time * 1e6,
+                static_cast<unsigned long long>(frame.population),
+                static_cast<unsigned long long>(frame.births),
+                static_cast<unsigned long long>(frame.deaths));
+        fprintf(out, ",\n{\"name\": \"draw calls\", \"ph\": \"C\", \"pid\": 1, "
+                "\"tid\": %d, \"ts\": %.3f, \"args\": {\"calls\": %llu}}",
+                PF_RENDER_THREAD, frame.time * 1e6,
+                static_cast<unsigned long long>(frame.draw_calls));
+    }
+    fprintf(out, "\n]}\n");
+
+    return (EXIT_SUCCESS);
+}
+
+/* a row per frame: when it ended, the board it showed and each zone's time */
+int
+Profiler::write_csv(FILE *out) const
+{
+    fprintf(out, "time,generation,population,births,deaths,draw_calls");
+    for (int z = 0; z < PF_ZONES; z++)
+        fprintf(out, ",%s_ms", zone_names[z]);
+    fprintf(out, "\n");
+
+    for (ProfileFrame const& frame : this->pf_frames) {
+
+        fprintf(out, "%.6f,%llu,%llu,%llu,%llu,%llu", frame.time,
+                static_cast<unsigned long long>(frame.generation),
+                static_cast<unsigned long long>(frame.population),
+                static_cast<unsigned long long>(frame.births),
+                static_cast<unsigned long long>(frame.deaths),
+                static_cast<unsigned long long>(frame.draw_calls));
+        for (int z = 0; z < PF_ZONES; z++)
+            fprintf(out, ",%.4f", frame.seconds[z] * 1e3);
+        fprintf(out, "\n");
+    }
+
+    return (EXIT_SUCCESS);
+}
+
+/*
+ * writes what was kept to path, as CSV if it ends in .csv and as a Chrome
+ * trace otherwise; once the profiled threads have stopped
+ */
+int
+Profiler::write(char const *path) const
+{
+    size_t length = strlen(path);
+    bool csv = length >= 4 && !strcmp(path + length - 4, ".csv");
+    uint64_t dropped = 0;
+    FILE *out;
+
+    if (!(out = fopen(path, "w"))) {
+
+        fprintf(stderr, "[ERROR] :: %s :: cannot open %s\n", __func__, path);
+        return (EXIT_FAILURE);
+    }
+
+    if (csv)
+        this->write_csv(out);
+    else
+        this->write_trace(out);
+
+    if (ferror(out) | fclose(out)) {
+
+        fprintf(stderr, "[ERROR] :: %s :: cannot write %s\n", __func__, path);
+        return (EXIT_FAILURE);
+    }
+
+    for (Thread const& thread : this->pf_threads)
+        dropped += thread.dropped;
+    if (dropped)
+        fprintf(stderr, "[INFO] :: %s :: %llu events past the first %d of a "
+                "thread were not kept\n", __func__,
+                static_cast<unsigned long long>(dropped), PF_MAX_EVENTS);
+
+    return (EXIT_SUCCESS);
+}
@@ -0,0 +1,157 @@
+/**
+ * PROFILE:
+ *  This file contains all prototypes and utilities needed to time where
+ *  the window's frames and the generations behind them spend their time
+ *
+ *  A ProfileScope times the block it is declared in against one of the
+ *  PF_ zones. Every zone belongs to one thread, and every thread adds to
+ *  its own totals and events, so a timer costs two clock reads and no
+ *  locks while the profiler is on, and one relaxed load while it is off.
+ *  The render thread takes its totals once a frame, the sim thread once a
+ *  snapshot, and the two meet in a ProfileFrame handed over with the
+ *  snapshot. Events and frames are only kept when a trace was asked for,
+ *  and are written out when the window closes.
+ *
+ *  file: profile.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+#define PF_MAX_EVENTS (1 << 21)     /* per thread, kept for a trace */
+#define PF_AVERAGE_PERIOD 0.5       /* seconds the overlay's figures cover */
+
+enum ProfileThread : uint8_t {
+    PF_RENDER_THREAD,
+    PF_SIM_THREAD,
+    PF_THREADS,
+};
+
+/* the render thread's zones come first, then the sim thread's */
+enum ProfileZone : uint8_t {
+    PF_WAIT,                        /* asleep on input or a new snapshot */
+    PF_EVENTS,
+    PF_DISPLAY,
+    PF_MOUSE,
+    PF_OVERLAY,
+    PF_PRESENT,
+    PF_STEP,
+    PF_HISTORY,                     /* recording, inside PF_STEP while stepping */
+    PF_PUBLISH,
+    PF_ZONES,
+};
+
+/* what one frame cost, and the board it showed */
+struct ProfileFrame {
+    double time;                    /* seconds since the profiler started */
+    double seconds[PF_ZONES];       /* the sim thread's since the last snapshot */
+    uint64_t generation;
+    uint64_t population;
+    uint64_t births;                /* over the generations stepped since */
+    uint64_t deaths;                /* the last snapshot */
+    uint64_t draw_calls;
+};
+
+char const *profile_zone_name(ProfileZone);
+
+class Profiler
+{
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Event {
+            int64_t start;              /* nanoseconds since pf_epoch */
+            int64_t duration;
+            ProfileZone zone;
+        };
+
+        struct alignas(64) Thread {
+            std::vector<Event> events;
+            double seconds[PF_ZONES];   /* only this thread's zones are used */
+            uint64_t dropped;           /* events past PF_MAX_EVENTS */
+        };
+
+        std::atomic<bool> pf_enabled;
+        bool pf_overlay;
+        bool pf_tracing;
+        Clock::time_point pf_epoch;
+        Thread pf_threads[PF_THREADS];
+
+        /* render thread only */
+        std::vector<ProfileFrame> pf_frames;
+        ProfileFrame pf_last;
+        ProfileFrame pf_sum;            /* frames since pf_window_start */
+        int pf_window_frames;
+        double pf_window_start;
+        uint64_t pf_window_generation;
+        double pf_average[PF_ZONES];    /* per frame, over the last window */
+        double pf_fps;
+        double pf_rate;                 /* generations per second */
+
+        int write_trace(FILE *) const;
+        int write_csv(FILE *) const;
+
+    public:
+        Profiler(void);
+
+        Profiler(Profiler const&) = delete;
+        Profiler& operator=(Profiler const&) = delete;
+
+        void set_overlay(bool);
+        void set_tracing(bool);
+        [[ nodiscard ]] bool overlay(void) const { return this->pf_overlay; }
+        [[ nodiscard ]] bool tracing(void) const { return this->pf_tracing; }
+
+        [[ nodiscard ]] bool enabled(void) const
+        {
+            return this->pf_enabled.load(std::memory_order_relaxed);
+        }
+
+        [[ nodiscard ]] double now(void) const;
+        void add(ProfileZone, Clock::time_point, Clock::time_point);
+        double take(ProfileZone);
+        void frame(ProfileFrame const&);
+
+        [[ nodiscard ]] ProfileFrame const& last(void) const { return this->pf_last; }
+        [[ nodiscard ]] double average(ProfileZone z) const { return this->pf_average[z]; }
+        [[ nodiscard ]] double fps(void) const { return this->pf_fps; }
+        [[ nodiscard ]] double rate(void) const { return this->pf_rate; }
+
+        int write(char const *) const;
+};
+
+/* times the rest of the enclosing block against zone, if the profiler is on */
+class ProfileScope
+{
+    private:
+        Profiler& ps_profiler;
+        ProfileZone ps_zone;
+        bool ps_timing;
+        std::chrono::steady_clock::time_point ps_start;
+
+    public:
+        ProfileScope(Profiler& profiler, ProfileZone zone)
+            : ps_profiler(profiler), ps_zone(zone)
+        {
+            this->ps_timing = profiler.enabled();
+            if (this->ps_timing)
+                this->ps_start = std::chrono::steady_clock::now();
+        }
+
+        ~ProfileScope(void)
+        {
+            if (this->ps_timing)
+                this->ps_profiler.add(this->ps_zone, this->ps_start,
+                        std::chrono::steady_clock::now());
+        }
+
+        ProfileScope(ProfileScope const&) = delete;
+        ProfileScope& operator=(ProfileScope const&) = delete;
+};
@@ -0,0 +1,156 @@
+/**
+ * PYRAMID:
+ *  This file contains the population-density pyramid
+ *
+ *  file: pyramid.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <bit>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <algorithm>
+
+#include "board.hpp"
+#include "pyramid.hpp"
+
+DensityPyramid::DensityPyramid(void)
+{
+    this->d_width = 0;
+    this->d_height = 0;
+}
+
+/* recounts one base block straight from the packed rows */
+void
+DensityPyramid::count_base(BoardView const& view, int bx, int by)
+{
+    Level& base = this->d_levels[0];
+    int last_row = std::min(view.height, (by + 1) << D_BASE_LEVEL);
+    int shift = (bx << D_BASE_LEVEL) & 63;
+    uint32_t count = 0;
+
+    for (int y = by << D_BASE_LEVEL; y < last_row; y++) {
+
+        uint64_t word = view.row(y)[(bx << D_BASE_LEVEL) >> 6];
+        count += std::popcount((word >> shift) & 0xff);
+    }
+
+    base.counts[static_cast<size_t>(by) * base.width + bx] = count;
+}
+
+void
+DensityPyramid::sum_children(int level, int x, int y)
+{
+    Level const& below = this->d_levels[level - 1];
+    Level& here = this->d_levels[level];
+    uint32_t count = 0;
+
+    for (int cy = 2 * y; cy < std::min(2 * y + 2, below.height); cy++) {
+
+        for (int cx = 2 * x; cx < std::min(2 * x + 2, below.width); cx++)
+            count += below.counts[static_cast<size_t>(cy) * below.width + cx];
+    }
+
+    here.counts[static_cast<size_t>(y) * here.width + x] = count;
+}
+
+/*
+ * brings the pyramid up to date with view, recounting only the blocks
+ * under dirty tiles (one flag per tile, see Board::dirty_tiles); a board
+ * of a new size, or a dirty of nullptr, rebuilds everything
+ */
+void
+DensityPyramid::update(BoardView const& view, uint8_t const *dirty)
+{
+    int tiles_x = view.words;
+    int tiles_y = (view.height + B_TILE_ROWS - 1) / B_TILE_ROWS;
+    std::vector<std::pair<int, int>> tiles;
+
+    if (view.width != this->d_width || view.height != this->d_height) {
+
+        this->d_levels.clear();
+        for (int level = D_BASE_LEVEL; ; level++) {
+
+            int w = ((view.width - 1) >> level) + 1;
+            int h = ((view.height - 1) >> level) + 1;
+
+            this->d_levels.push_back({w, h,
+                    std::vector<uint32_t>(static_cast<size_t>(w) * h)});
+            if (w == 1 && h == 1)
+                break;
+        }
+        this->d_width = view.width;
+        this->d_height = view.height;
+        dirty = nullptr;
+    }
+
+    for (int ty = 0; ty < tiles_y; ty++) {
+
+        for (int tx = 0; tx < tiles_x; tx++) {
+
+            if (!dirty || dirty[ty * tiles_x + tx])
+                tiles.emplace_back(tx, ty);
+        }
+    }
+
+    /* a tile is 64 cells square, so it covers whole base blocks */
+    Level const& base = this->d_levels[0];
+    int per_tile = 64 >> D_BASE_LEVEL;
+
+    for (auto [tx, ty] : tiles) {
+
+        for (int by = ty * per_tile; by < std::min((ty + 1) * per_tile, base.height); by++) {
+
+            for (int bx = tx * per_tile; bx < std::min((tx + 1) * per_tile, base.width); bx++)
+                this->count_base(view, bx, by);
+        }
+    }
+
+    /* level by level, so every parent sums children that are already current */
+    for (size_t i = 1; i < this->d_levels.size(); i++) {
+
+        int level = D_BASE_LEVEL + static_cast<int>(i);
+        Level const& here = this->d_levels[i];
+
+        for (auto [tx, ty] : tiles) {
+
+            int x0 = (tx * 64) >> level;
+            int y0 = (ty * B_TILE_ROWS) >> level;
+            int x1 = std::min((tx * 64 + 63) >> level, here.width - 1);
+            int y1 = std::min((ty * B_TILE_ROWS + B_TILE_ROWS - 1) >> level,
+                    here.height - 1);
+
+            for (int y = y0; y <= y1; y++) {
+
+                for (int x = x0; x <= x1; x++)
+                    this->sum_children(static_cast<int>(i), x, y);
+            }
+        }
+    }
+}
+
+/* live cells in block (x, y) of the given level, 2^level cells on a side */
+uint32_t
+DensityPyramid::count(BoardView const& view, int level, int x, int y) const
+{
+    if (level >= D_BASE_LEVEL) {
+
+        Level const& l = this->d_levels[std::min(level, this->top_level())
+            - D_BASE_LEVEL];
+        return (l.counts[static_cast<size_t>(y) * l.width + x]);
+    }
+
+    /* finer blocks never straddle a word, so a masked popcount per row does */
+    int size = 1 << level;
+    int x0 = x << level;
+    uint64_t mask = ((uint64_t{1} << size) - 1) << (x0 & 63);
+    int last_row = std::min(view.height, (y + 1) << level);
+    uint32_t count = 0;
+
+    for (int row = y << level; row < last_row; row++)
+        count += std::popcount(view.row(row)[x0 >> 6] & mask);
+
+    return (count);
+}
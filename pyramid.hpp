@@ -0,0 +1,55 @@
+/**
+ * PYRAMID:
+ *  This file contains all prototypes and utilities needed for the
+ *  population-density pyramid used to draw boards zoomed out below one
+ *  pixel per cell
+ *
+ *  Level n of the pyramid counts the live cells in each 2^n x 2^n block of
+ *  the board. Levels from D_BASE_LEVEL up are stored; the finer ones are
+ *  cheap enough to count straight from the packed rows. Only the blocks
+ *  under tiles the board reports as dirty are recounted, so keeping the
+ *  pyramid current costs as much as the activity, not the board size.
+ *
+ *  file: pyramid.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "board.hpp"
+
+/* 8x8 blocks, the finest level worth storing */
+#define D_BASE_LEVEL 3
+
+class DensityPyramid
+{
+    private:
+        struct Level {
+            int width;          /* in blocks */
+            int height;
+            std::vector<uint32_t> counts;
+        };
+
+        std::vector<Level> d_levels;        /* d_levels[i] is level D_BASE_LEVEL + i */
+        int d_width;                        /* board the pyramid was built for */
+        int d_height;
+
+        void count_base(BoardView const&, int, int);
+        void sum_children(int, int, int);
+
+    public:
+        DensityPyramid(void);
+
+        void update(BoardView const&, uint8_t const *);
+
+        [[ nodiscard ]] int top_level(void) const
+        {
+            return D_BASE_LEVEL + static_cast<int>(this->d_levels.size()) - 1;
+        }
+
+        [[ nodiscard ]] uint32_t count(BoardView const&, int, int, int) const;
+};
@@ -8,7 +8,12 @@
  *  year: 2022
  */
 
+#include <array>
+#include <cmath>
 #include <memory>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
 
 #if defined(__gnu_linux__) || defined(__linux__)
     #include <SDL2/SDL.h>
@@ -20,9 +25,14 @@
     #include <SDL2_gfxPrimitives.h>
 #endif
 
+#include "board.hpp"
 #include "window.hpp"
+#include "pyramid.hpp"
 #include "renderer.hpp"
 
+#define R_ALIVE_PIXEL 0xFFFFFFFFu
+#define R_DEAD_PIXEL 0xFF000000u
+
 void
 Renderer::init(const std::shared_ptr<Window>& window, int renderer_index,
         uint32_t renderer_flags)
@@ -44,60 +54,265 @@ int
 Renderer::clear(void)
 {
     int rc;
-    auto *r = new uint8_t,
-         *g = new uint8_t,
-         *b = new uint8_t,
-         *a = new uint8_t;
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t a;
 
     /* store previous draw colour for 'context-switching' */
-    rc = SDL_GetRenderDrawColor(this->renderer, r, g, b, a);
+    rc = SDL_GetRenderDrawColor(this->renderer, &r, &g, &b, &a);
     if (rc) {
 
         /* if we cant determine previous draw colour, forget about it */
         fprintf(stderr,
                 "[INFO] :: %s :: could not determine previous draw colour\n",
                 __func__);
-        *r = 0;
-        *g = 0;
-        *b = 0;
-        *a = 255;
+        r = 0;
+        g = 0;
+        b = 0;
+        a = 255;
     }
     this->set_draw_colour(0, 0, 0, 255);
     rc = SDL_RenderClear(this->renderer);
+    this->draw_calls++;
     /* re-instate previous draw colour */
-    this->set_draw_colour(*r, *g, *b, *a);
-
-    delete r;
-    delete g;
-    delete b;
-    delete a;
+    this->set_draw_colour(r, g, b, a);
 
     return (rc);
 }
 
-int
-Renderer::draw_selection_box(int16_t x, int16_t y, uint8_t r, uint8_t g,
+/* finds or starts the batch for this colour and kind */
+void
+Renderer::queue(SDL_Rect const& rect, bool fill, uint8_t r, uint8_t g,
         uint8_t b, uint8_t a)
 {
-    int rc;
+    uint32_t colour = uint32_t{r} << 24 | uint32_t{g} << 16 | uint32_t{b} << 8 | a;
+
+    for (Batch& batch : this->batches) {
+
+        if (batch.colour == colour && batch.fill == fill) {
+
+            batch.rects.push_back(rect);
+            return;
+        }
+    }
+    this->batches.push_back({colour, fill, {rect}});
+}
+
+/* queues the edges of rect, drawn at the next flush() */
+void
+Renderer::add_outline(SDL_Rect const& rect, uint8_t r, uint8_t g, uint8_t b,
+        uint8_t a)
+{
+    this->queue(rect, false, r, g, b, a);
+}
+
+/* queues rect filled, blended if a is below 255, drawn at the next flush() */
+void
+Renderer::add_fill(SDL_Rect const& rect, uint8_t r, uint8_t g, uint8_t b,
+        uint8_t a)
+{
+    this->queue(rect, true, r, g, b, a);
+}
+
+/*
+ * draws everything queued, one SDL call per colour and kind, in the order
+ * the batches were first used. Batches keep their memory for the next frame
+ */
+int
+Renderer::flush(void)
+{
+    int rc = 0;
+
+    for (Batch& batch : this->batches) {
+
+        if (batch.rects.empty())
+            continue;
+
+        uint8_t a = batch.colour & 0xFF;
+        int count = static_cast<int>(batch.rects.size());
+
+        rc |= SDL_SetRenderDrawBlendMode(this->renderer,
+                (a < 255) ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+        rc |= this->set_draw_colour(batch.colour >> 24, batch.colour >> 16,
+                batch.colour >> 8, a);
+        rc |= (batch.fill)
+            ? SDL_RenderFillRects(this->renderer, batch.rects.data(), count)
+            : SDL_RenderDrawRects(this->renderer, batch.rects.data(), count);
+        this->draw_calls++;
+        batch.rects.clear();
+    }
 
-    rc = roundedRectangleRGBA(this->renderer, x, y, x + 10, y + 10, 2,
-            r, g, b, a);
     return (rc);
 }
 
+/* one line of text in the gfx library's built-in 8x8 font, (x, y) its top-left */
 int
-Renderer::draw_filled_box(int16_t x, int16_t y, uint8_t r, uint8_t g,
-        uint8_t b, uint8_t a)
+Renderer::draw_text(int16_t x, int16_t y, char const *text, uint8_t r,
+        uint8_t g, uint8_t b, uint8_t a)
 {
     int rc;
 
-    rc = boxRGBA(this->renderer, x, y, x + 10, y + 10, r, g, b, a);
+    rc = stringRGBA(this->renderer, x, y, text, r, g, b, a);
+    this->draw_calls++;
     return (rc);
 }
 
+/* the draw calls made since the last time they were taken */
+uint64_t
+Renderer::take_draw_calls(void)
+{
+    uint64_t calls = this->draw_calls;
+
+    this->draw_calls = 0;
+    return (calls);
+}
+
+/* anything still queued is drawn first */
 void
 Renderer::present(void)
 {
+    this->flush();
     SDL_RenderPresent(this->renderer);
 }
+
+/* the size in pixels of what is being drawn to */
+int
+Renderer::output_size(int *width, int *height)
+{
+    int rc;
+
+    rc = SDL_GetRendererOutputSize(this->renderer, width, height);
+    return (rc);
+}
+
+/* grows the streaming texture to hold at least width x height texels */
+int
+Renderer::reserve_texture(int width, int height)
+{
+    if (this->board_texture && this->texture_width >= width
+            && this->texture_height >= height)
+        return (EXIT_SUCCESS);
+
+    width = std::max(width, this->texture_width);
+    height = std::max(height, this->texture_height);
+    if (this->board_texture)
+        SDL_DestroyTexture(this->board_texture);
+
+    this->board_texture = SDL_CreateTexture(this->renderer,
+            SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (!this->board_texture) {
+
+        fprintf(stderr, "[ERROR] :: %s :: SDL_CreateTexture: %s\n", __func__,
+                SDL_GetError());
+        this->texture_width = 0;
+        this->texture_height = 0;
+        return (EXIT_FAILURE);
+    }
+    this->texture_width = width;
+    this->texture_height = height;
+    return (EXIT_SUCCESS);
+}
+
+/* one pixel per cell for count cells of a packed row, starting at cell x */
+static void
+expand_cells(uint64_t const *row, int x, int count, uint32_t *dst)
+{
+    static auto const pixel_table = [] {
+        std::array<std::array<uint32_t, 8>, 256> table;
+
+        for (int byte = 0; byte < 256; byte++) {
+
+            for (int b = 0; b < 8; b++)
+                table[byte][b] = ((byte >> b) & 1) ? R_ALIVE_PIXEL : R_DEAD_PIXEL;
+        }
+        return table;
+    }();
+    int end = x + count;
+
+    /* bit by bit up to a byte boundary, whole bytes through the table, then the tail */
+    for (; x < end && (x & 7); x++)
+        *dst++ = ((row[x >> 6] >> (x & 63)) & 1) ? R_ALIVE_PIXEL : R_DEAD_PIXEL;
+    for (; x + 8 <= end; x += 8, dst += 8) {
+
+        uint8_t byte = static_cast<uint8_t>(row[x >> 6] >> (x & 63));
+        memcpy(dst, pixel_table[byte].data(), sizeof(pixel_table[byte]));
+    }
+    for (; x < end; x++)
+        *dst++ = ((row[x >> 6] >> (x & 63)) & 1) ? R_ALIVE_PIXEL : R_DEAD_PIXEL;
+}
+
+/*
+ * the texture holds region, the blocks in view at the given pyramid level,
+ * one texel each from its top-left: level 0 is the cells themselves, coarser
+ * levels are shaded grey by how full each 2^level square block is. Only the
+ * blocks in part are rewritten, the rest of the image is kept as it was
+ */
+int
+Renderer::upload_blocks(BoardView const& board, DensityPyramid const& pyramid,
+        int level, SDL_Rect const& region, SDL_Rect const& part)
+{
+    static auto const shade_table = [] {
+        std::array<uint32_t, 256> table;
+
+        /* square root, so sparse areas still show up against the background */
+        for (int i = 0; i < 256; i++) {
+
+            uint32_t grey = static_cast<uint32_t>(255 * std::sqrt(i / 255.0) + 0.5);
+            table[i] = 0xFF000000u | grey << 16 | grey << 8 | grey;
+        }
+        return table;
+    }();
+    SDL_Rect lock;
+    void *pixels;
+    int pitch;
+
+    if (!SDL_IntersectRect(&region, &part, &lock))
+        return (EXIT_SUCCESS);
+    if (this->reserve_texture(region.w, region.h))
+        return (EXIT_FAILURE);
+
+    int x0 = lock.x;
+    int y0 = lock.y;
+
+    lock.x -= region.x;
+    lock.y -= region.y;
+    if (SDL_LockTexture(this->board_texture, &lock, &pixels, &pitch)) {
+
+        fprintf(stderr, "[ERROR] :: %s :: SDL_LockTexture: %s\n", __func__,
+                SDL_GetError());
+        return (EXIT_FAILURE);
+    }
+
+    for (int y = 0; y < lock.h; y++) {
+
+        uint32_t *dst = reinterpret_cast<uint32_t *>(
+                static_cast<uint8_t *>(pixels) + static_cast<size_t>(y) * pitch);
+
+        if (!level) {
+
+            expand_cells(board.row(y0 + y), x0, lock.w, dst);
+            continue;
+        }
+
+        for (int x = 0; x < lock.w; x++) {
+
+            uint64_t count = pyramid.count(board, level, x0 + x, y0 + y);
+            dst[x] = shade_table[std::min<uint64_t>(255, (count * 255) >> (2 * level))];
+        }
+    }
+
+    SDL_UnlockTexture(this->board_texture);
+    return (EXIT_SUCCESS);
+}
+
+/* scales the uploaded region (src, in texels) onto dst, nearest neighbour */
+int
+Renderer::draw_board(SDL_Rect const *src, SDL_Rect const *dst)
+{
+    int rc;
+
+    rc = SDL_RenderCopy(this->renderer, this->board_texture, src, dst);
+    this->draw_calls++;
+    return (rc);
+}
@@ -11,6 +11,8 @@
 #pragma once
 
 #include <memory>
+#include <vector>
+#include <cstdint>
 
 #if defined(__gnu_linux__) || defined(__linux__)
     #include <SDL2/SDL.h>
@@ -20,15 +22,44 @@
     #include <SDL.h>
 #endif
 
+#include "board.hpp"
 #include "window.hpp"
+#include "pyramid.hpp"
 
 class Renderer
 {
     private:
         SDL_Renderer *renderer;
+        SDL_Texture *board_texture;         /* the visible region, one texel per block */
+        int texture_width;
+        int texture_height;
+        uint64_t draw_calls;                /* since the last take_draw_calls() */
+
+        /* rectangles queued for this frame, one batch per colour and kind */
+        struct Batch {
+            uint32_t colour;                /* RGBA, red in the top byte */
+            bool fill;
+            std::vector<SDL_Rect> rects;
+        };
+        std::vector<Batch> batches;
+
+        int reserve_texture(int, int);
+        void queue(SDL_Rect const&, bool, uint8_t, uint8_t, uint8_t, uint8_t);
     public:
-        explicit Renderer(SDL_Renderer *r) { this->renderer = r; }
-        ~Renderer(void) { SDL_DestroyRenderer(this->renderer); }
+        explicit Renderer(SDL_Renderer *r)
+        {
+            this->renderer = r;
+            this->board_texture = nullptr;
+            this->texture_width = 0;
+            this->texture_height = 0;
+            this->draw_calls = 0;
+        }
+        ~Renderer(void)
+        {
+            if (this->board_texture)
+                SDL_DestroyTexture(this->board_texture);
+            SDL_DestroyRenderer(this->renderer);
+        }
 
         void init(const std::shared_ptr<Window>& window, int, uint32_t);
         SDL_Renderer *self(void) { return this->renderer; }
@@ -36,9 +67,16 @@ class Renderer
         int set_draw_colour(uint8_t, uint8_t, uint8_t, uint8_t);
         int clear(void);
         void present(void);
+        int output_size(int *, int *);
+
+        void add_outline(SDL_Rect const&, uint8_t, uint8_t, uint8_t, uint8_t);
+        void add_fill(SDL_Rect const&, uint8_t, uint8_t, uint8_t, uint8_t);
+        int flush(void);
+        int draw_text(int16_t, int16_t, char const *, uint8_t, uint8_t,
+                uint8_t, uint8_t);
+        uint64_t take_draw_calls(void);
 
-        int draw_selection_box(int16_t, int16_t, uint8_t, uint8_t, uint8_t,
-                uint8_t);
-        int draw_filled_box(int16_t, int16_t, uint8_t, uint8_t, uint8_t,
-                uint8_t);
+        int upload_blocks(BoardView const&, DensityPyramid const&, int,
+                SDL_Rect const&, SDL_Rect const&);
+        int draw_board(SDL_Rect const *, SDL_Rect const *);
 };
@@ -0,0 +1,133 @@
+/**
+ * RULE:
+ *  This file contains the parsing and printing of Life-like rules
+ *
+ *  file: rule.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <string>
+#include <cctype>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+
+#include "rule.hpp"
+
+/* case-insensitive, as rule names are */
+static bool
+same_name(char const *a, char const *b)
+{
+    for (; *a && *b; a++, b++) {
+
+        if (tolower(static_cast<unsigned char>(*a))
+                != tolower(static_cast<unsigned char>(*b)))
+            return (false);
+    }
+
+    return (!*a && !*b);
+}
+
+/* reads the run of neighbour counts at *p into *mask */
+static bool
+read_counts(char const **p, uint16_t *mask)
+{
+    *mask = 0;
+    for (; isdigit(static_cast<unsigned char>(**p)); (*p)++) {
+
+        if (**p > '8')
+            return (false);
+        *mask |= 1 << (**p - '0');
+    }
+
+    return (true);
+}
+
+/*
+ * accepts a rule name from named_rules, "B3/S23" (either way round, any
+ * case) or the older survival-first "23/3"
+ */
+int
+parse_rule(char const *text, Rule *rule)
+{
+    char const *p = text;
+    uint16_t first;
+    uint16_t second;
+
+    for (auto const& named : named_rules) {
+
+        if (same_name(text, named.name)) {
+
+            *rule = named.rule;
+            return (EXIT_SUCCESS);
+        }
+    }
+
+    if (*p == 'B' || *p == 'b' || *p == 'S' || *p == 's') {
+
+        bool birth_first = (*p == 'B' || *p == 'b');
+        char other = birth_first ? 's' : 'b';
+
+        p++;
+        if (!read_counts(&p, &first) || *p++ != '/'
+                || tolower(static_cast<unsigned char>(*p++)) != other
+                || !read_counts(&p, &second) || *p)
+            goto malformed;
+
+        *rule = birth_first ? Rule{first, second} : Rule{second, first};
+    } else {
+
+        if (!read_counts(&p, &first) || *p++ != '/' || !read_counts(&p, &second)
+                || *p)
+            goto malformed;
+
+        *rule = {second, first};
+    }
+
+    /* a birth on no neighbours would fill empty space, which no engine expects */
+    if (rule->birth & 1) {
+
+        fprintf(stderr, "[ERROR] :: %s :: B0 rules are not supported: %s\n",
+                __func__, text);
+        return (EXIT_FAILURE);
+    }
+    return (EXIT_SUCCESS);
+
+malformed:
+    fprintf(stderr, "[ERROR] :: %s :: not a rule: %s\n", __func__, text);
+    return (EXIT_FAILURE);
+}
+
+std::string
+rule_string(Rule const& rule)
+{
+    std::string out = "B";
+
+    for (int n = 0; n <= 8; n++) {
+
+        if ((rule.birth >> n) & 1)
+            out += static_cast<char>('0' + n);
+    }
+    out += "/S";
+    for (int n = 0; n <= 8; n++) {
+
+        if ((rule.survive >> n) & 1)
+            out += static_cast<char>('0' + n);
+    }
+
+    return (out);
+}
+
+/* the rule's index in named_rules, or -1 if it has no name */
+int
+named_rule_index(Rule const& rule)
+{
+    for (size_t i = 0; i < R_NAMED_RULES; i++) {
+
+        if (named_rules[i].rule == rule)
+            return static_cast<int>(i);
+    }
+
+    return (-1);
+}
@@ -0,0 +1,73 @@
+/**
+ * RULE:
+ *  This file contains all prototypes and utilities needed for Life-like
+ *  rules, the outer-totalistic rules written in B/S notation
+ *
+ *  A rule is a pair of masks over neighbour counts 0 to 8: a dead cell with
+ *  n live neighbours is born if bit n of birth is set, and a live one
+ *  survives if bit n of survive is. Conway's Life is B3/S23. The named
+ *  rules below get stepping kernels compiled for their masks; any other
+ *  rule runs through a kernel that reads the masks at run time.
+ *
+ *  file: rule.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+struct Rule {
+    uint16_t birth;
+    uint16_t survive;
+
+    /* both masks in one word, birth in the low 9 bits */
+    [[ nodiscard ]] constexpr uint32_t bits(void) const
+    {
+        return this->birth | static_cast<uint32_t>(this->survive) << 9;
+    }
+
+    constexpr bool operator==(Rule const&) const = default;
+};
+
+/* the mask of a string of neighbour counts, e.g. "23" */
+constexpr uint16_t
+rule_counts(char const *digits)
+{
+    uint16_t mask = 0;
+
+    for (; *digits; digits++)
+        mask |= 1 << (*digits - '0');
+
+    return (mask);
+}
+
+#define R_CONWAY (Rule{rule_counts("3"), rule_counts("23")})
+
+struct NamedRule {
+    char const *name;
+    Rule rule;
+};
+
+inline constexpr NamedRule named_rules[] = {
+    {"life", R_CONWAY},
+    {"highlife", {rule_counts("36"), rule_counts("23")}},
+    {"daynight", {rule_counts("3678"), rule_counts("34678")}},
+    {"seeds", {rule_counts("2"), rule_counts("")}},
+    {"lifewithoutdeath", {rule_counts("3"), rule_counts("012345678")}},
+    {"maze", {rule_counts("3"), rule_counts("12345")}},
+    {"2x2", {rule_counts("36"), rule_counts("125")}},
+    {"34life", {rule_counts("34"), rule_counts("34")}},
+    {"replicator", {rule_counts("1357"), rule_counts("1357")}},
+    {"morley", {rule_counts("368"), rule_counts("245")}},
+    {"diamoeba", {rule_counts("35678"), rule_counts("5678")}},
+    {"drylife", {rule_counts("37"), rule_counts("23")}},
+};
+
+#define R_NAMED_RULES (sizeof(named_rules) / sizeof(named_rules[0]))
+
+int parse_rule(char const *, Rule *);
+[[ nodiscard ]] std::string rule_string(Rule const&);
+[[ nodiscard ]] int named_rule_index(Rule const&);
@@ -0,0 +1,103 @@
+/**
+ * SCHEDULER:
+ *  This file contains the fixed-timestep scheduler for the simulation
+ *
+ *  file: scheduler.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+#include "scheduler.hpp"
+
+Scheduler::Scheduler(int rate, double budget)
+{
+    this->s_rate = std::max(rate, 0);
+    this->s_budget = budget;
+    this->s_step_cost = 0;
+    this->reset();
+}
+
+void
+Scheduler::set_rate(int rate)
+{
+    this->s_rate = std::max(rate, 0);
+    this->reset();
+}
+
+/* forgets any time that passed while nothing was being run, e.g. paused */
+void
+Scheduler::reset(void)
+{
+    this->s_accumulator = 0;
+    this->s_last = clock::now();
+}
+
+/*
+ * nothing is known of a generation's cost until the first batch is timed,
+ * so that batch is a single generation, however large the board
+ */
+uint64_t
+Scheduler::batch_cap(void) const
+{
+    if (!this->s_step_cost)
+        return (1);
+
+    return std::max<uint64_t>(1,
+            static_cast<uint64_t>(this->s_budget / this->s_step_cost));
+}
+
+/* how many generations to run now, given the time since the last call */
+uint64_t
+Scheduler::due(void)
+{
+    clock::time_point now = clock::now();
+    std::chrono::duration<double> elapsed = now - this->s_last;
+    uint64_t cap = this->batch_cap();
+
+    this->s_last = now;
+    if (this->s_rate == S_UNLIMITED)
+        return (cap);
+
+    this->s_accumulator += elapsed.count() * this->s_rate;
+
+    double owed = std::floor(this->s_accumulator);
+    if (owed > static_cast<double>(cap)) {
+
+        /* can't keep up: run what fits and drop the rest of the debt */
+        this->s_accumulator = 0;
+        return (cap);
+    }
+
+    this->s_accumulator -= owed;
+    return static_cast<uint64_t>(owed);
+}
+
+/* feeds back how long a batch really took, to size the next ones */
+void
+Scheduler::ran(uint64_t generations, double seconds)
+{
+    if (!generations)
+        return;
+
+    double cost = std::max(seconds / generations, 1e-9);
+
+    if (!this->s_step_cost)
+        this->s_step_cost = cost;
+    else
+        this->s_step_cost = 0.75 * this->s_step_cost + 0.25 * cost;
+}
+
+/* seconds until the next generation falls due */
+double
+Scheduler::idle_time(void) const
+{
+    if (this->s_rate == S_UNLIMITED)
+        return (0);
+
+    return (1.0 - this->s_accumulator) / this->s_rate;
+}
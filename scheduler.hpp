@@ -0,0 +1,49 @@
+/**
+ * SCHEDULER:
+ *  This file contains all prototypes and utilities needed for the
+ *  fixed-timestep scheduler that decides how many generations the
+ *  simulation runs at a time
+ *
+ *  Elapsed time is turned into generations owed through an accumulator, so
+ *  any rate is kept on average however the work is batched. Batches are
+ *  capped by the measured cost of a generation so each one fits in the
+ *  frame budget; when the board is too slow to keep up, the debt is
+ *  dropped rather than letting it snowball. A rate of 0 runs as fast as
+ *  possible, one frame budget at a time.
+ *
+ *  file: scheduler.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#define S_UNLIMITED 0
+
+class Scheduler
+{
+    private:
+        using clock = std::chrono::steady_clock;
+
+        int s_rate;                 /* generations per second, or S_UNLIMITED */
+        double s_budget;            /* seconds one batch may take */
+        double s_accumulator;       /* generations owed, fractional */
+        double s_step_cost;         /* running average seconds per generation, 0 until measured */
+        clock::time_point s_last;
+
+        [[ nodiscard ]] uint64_t batch_cap(void) const;
+
+    public:
+        Scheduler(int, double);
+
+        void set_rate(int);
+        [[ nodiscard ]] int rate(void) const { return this->s_rate; }
+
+        void reset(void);
+        [[ nodiscard ]] uint64_t due(void);
+        void ran(uint64_t, double);
+        [[ nodiscard ]] double idle_time(void) const;
+};
@@ -0,0 +1,484 @@
+/**
+ * SHARD:
+ *  This file contains the coordinator and workers that run a dense board
+ *  split across several processes
+ *
+ *  file: shard.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <bit>
+#include <new>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/wait.h>
+#endif
+
+#include "rule.hpp"
+#include "board.hpp"
+#include "shard.hpp"
+#include "pattern.hpp"
+#include "checkpoint.hpp"
+#include "threadpool.hpp"
+
+ShardRun::ShardRun(void)
+{
+    this->sr_plan = {};
+    this->sr_words = 0;
+    this->sr_population = 0;
+}
+
+ShardRun::~ShardRun(void)
+{
+    for (FILE *part : this->sr_parts)
+        fclose(part);
+    for (FILE *part : this->sr_records)
+        fclose(part);
+}
+
+/* puts the bands' rows together into one pattern file */
+int
+ShardRun::write(FILE *out, char const *comments) const
+{
+    ShardPlan const& plan = this->sr_plan;
+
+    if (!strcmp(plan.format, "rle"))
+        return write_rle_parts(out, this->sr_parts, plan.width, plan.height,
+                plan.rule, comments);
+
+    return write_plaintext_parts(out, this->sr_parts, comments);
+}
+
+/* puts the bands' records together into one checkpoint of the last generation */
+int
+ShardRun::write_checkpoint(char const *path) const
+{
+    ShardPlan const& plan = this->sr_plan;
+
+    return write_checkpoint_parts(path, plan.width, plan.height, plan.rule,
+            plan.generation + plan.generations, this->sr_present.data(),
+            this->sr_records, this->sr_words);
+}
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+
+int
+ShardRun::run(ShardPlan const&)
+{
+    fprintf(stderr, "[ERROR] :: %s :: shards need fork() and shared memory\n",
+            __func__);
+    return (EXIT_FAILURE);
+}
+
+#else
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+        "rings are shared between processes");
+
+/* one direction of the rows passed between two neighbouring workers */
+struct Ring {
+    alignas(64) std::atomic<uint64_t> written;  /* rows sent so far */
+    alignas(64) std::atomic<uint64_t> read;     /* rows taken so far */
+};
+
+/*
+ * the memory every worker shares: a flag raised when any of them fails,
+ * two rings per worker (its first row going up, its last row going down)
+ * with their slots, and what each worker reports back at the end, its
+ * band's population and record words and which of its tiles have records
+ */
+class ShardRegion
+{
+    private:
+        void *sh_base;
+        size_t sh_size;
+        int sh_words;
+        std::atomic<int> *sh_failed;
+        Ring *sh_rings;
+        uint64_t *sh_slots;
+        uint64_t *sh_population;
+        uint64_t *sh_record_words;
+        uint8_t *sh_present;
+
+    public:
+        ShardRegion(void);
+        ~ShardRegion(void);
+
+        ShardRegion(ShardRegion const&) = delete;
+        ShardRegion& operator=(ShardRegion const&) = delete;
+
+        int map(int, int, size_t);
+
+        [[ nodiscard ]] std::atomic<int>& failed(void) { return *this->sh_failed; }
+        [[ nodiscard ]] Ring& ring(int i) { return this->sh_rings[i]; }
+        [[ nodiscard ]] uint64_t& population(int s) { return this->sh_population[s]; }
+        [[ nodiscard ]] uint64_t& record_words(int s) { return this->sh_record_words[s]; }
+        [[ nodiscard ]] uint8_t *present(void) { return this->sh_present; }
+
+        [[ nodiscard ]] uint64_t *slot(int ring, uint64_t n)
+        {
+            return this->sh_slots + (static_cast<size_t>(ring) * SH_RING_SLOTS
+                    + n % SH_RING_SLOTS) * this->sh_words;
+        }
+};
+
+ShardRegion::ShardRegion(void)
+{
+    this->sh_base = nullptr;
+    this->sh_size = 0;
+    this->sh_words = 0;
+    this->sh_failed = nullptr;
+    this->sh_rings = nullptr;
+    this->sh_slots = nullptr;
+    this->sh_population = nullptr;
+    this->sh_record_words = nullptr;
+    this->sh_present = nullptr;
+}
+
+ShardRegion::~ShardRegion(void)
+{
+    if (this->sh_base)
+        munmap(this->sh_base, this->sh_size);
+}
+
+/* maps the rings and the reports, before the workers are forked off to share them */
+int
+ShardRegion::map(int words, int shards, size_t tiles)
+{
+    size_t rings = 2 * static_cast<size_t>(shards);
+    size_t slots = rings * SH_RING_SLOTS * words;
+    char *base;
+
+    this->sh_size = 64 + rings * sizeof(Ring)
+        + (slots + 2 * static_cast<size_t>(shards)) * sizeof(uint64_t) + tiles;
+    this->sh_base = mmap(nullptr, this->sh_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (this->sh_base == MAP_FAILED) {
+
+        fprintf(stderr, "[ERROR] :: %s :: cannot map %zu bytes of shared "
+                "memory\n", __func__, this->sh_size);
+        this->sh_base = nullptr;
+        return (EXIT_FAILURE);
+    }
+
+    base = static_cast<char *>(this->sh_base);
+    this->sh_words = words;
+    this->sh_failed = new (base) std::atomic<int>(0);
+    this->sh_rings = reinterpret_cast<Ring *>(base + 64);
+    for (size_t i = 0; i < rings; i++)
+        new (&this->sh_rings[i]) Ring{{0}, {0}};
+    this->sh_slots = reinterpret_cast<uint64_t *>(base + 64 + rings * sizeof(Ring));
+    this->sh_population = this->sh_slots + slots;
+    this->sh_record_words = this->sh_population + shards;
+    this->sh_present = reinterpret_cast<uint8_t *>(this->sh_record_words + shards);
+
+    return (EXIT_SUCCESS);
+}
+
+/*
+ * loads the runs of a pattern that land on one band: row r of the band
+ * is row first + r of the board, wrapped round the torus, so the rows
+ * either side of the band are loaded into its ghost rows too
+ */
+class BandSink : public PatternSink
+{
+    private:
+        Board& s_band;
+        int64_t s_first;
+        int64_t s_height;
+
+    public:
+        BandSink(Board& band, int first, int height)
+            : s_band(band), s_first(first), s_height(height) {}
+
+        void set_run(int64_t x, int64_t y, int64_t count) override
+        {
+            int64_t width = this->s_band.width();
+
+            x %= width;
+            if (x < 0)
+                x += width;
+            y = (y - this->s_first) % this->s_height;
+            if (y < 0)
+                y += this->s_height;
+            count = std::min(count, width);
+
+            for (; y < this->s_band.height(); y += this->s_height) {
+
+                for (int64_t at = x, left = count; left > 0; at = 0) {
+
+                    int64_t span = std::min(left, width - at);
+
+                    this->s_band.set_run(static_cast<int>(at), static_cast<int>(y),
+                            static_cast<int>(span));
+                    left -= span;
+                }
+            }
+        }
+};
+
+/* polls counter until it reaches value, giving up if any worker has failed */
+static int
+wait_for(std::atomic<uint64_t> const& counter, uint64_t value,
+        std::atomic<int> const& failed)
+{
+    for (int spins = 0; counter.load(std::memory_order_acquire) < value; spins++) {
+
+        if (failed.load(std::memory_order_relaxed))
+            return (EXIT_FAILURE);
+        if (spins >= SH_SPINS)
+            std::this_thread::yield();
+    }
+
+    return (EXIT_SUCCESS);
+}
+
+/* puts row in the n-th slot of a ring, once its reader is done with it */
+static int
+send_row(ShardRegion& region, int ring, uint64_t n, uint64_t const *row,
+        int words)
+{
+    Ring& r = region.ring(ring);
+
+    if (n >= SH_RING_SLOTS
+            && wait_for(r.read, n - SH_RING_SLOTS + 1, region.failed()))
+        return (EXIT_FAILURE);
+
+    memcpy(region.slot(ring, n), row, words * sizeof(uint64_t));
+    r.written.store(n + 1, std::memory_order_release);
+    return (EXIT_SUCCESS);
+}
+
+/*
+ * takes the n-th row sent on a ring into row y of board, replacing only
+ * the words that differ so the tiles around the rest stay asleep
+ */
+static int
+receive_row(ShardRegion& region, int ring, uint64_t n, Board& board, int y)
+{
+    Ring& r = region.ring(ring);
+    uint64_t const *slot = region.slot(ring, n);
+    uint64_t const *row = board.row(y);
+    int words = board.words();
+
+    if (wait_for(r.written, n + 1, region.failed()))
+        return (EXIT_FAILURE);
+
+    for (int i = 0; i < words; i++) {
+
+        uint64_t mask = (i == words - 1) ? board.tail_mask() : ~uint64_t{0};
+
+        if ((slot[i] ^ row[i]) & mask)
+            board.set_word(i, y, slot[i]);
+    }
+    r.read.store(n + 1, std::memory_order_release);
+    return (EXIT_SUCCESS);
+}
+
+/*
+ * the first row of worker s's band; bands are whole tiles' rows, so each
+ * tile of the board's checkpoint is written by one worker
+ */
+static int
+band_start(int s, int shards, int height)
+{
+    int tiles_y = (height + B_TILE_ROWS - 1) / B_TILE_ROWS;
+
+    return std::min(height, static_cast<int>(static_cast<int64_t>(tiles_y) * s
+                / shards) * B_TILE_ROWS);
+}
+
+/*
+ * the n-th exchange of worker s: its own first and last rows (rows 1 and
+ * rows of band) go out, and the rows either side of it come into its
+ * ghost rows 0 and rows + 1
+ */
+static int
+exchange_rows(ShardRegion& region, Board& band, int s, int shards, uint64_t n)
+{
+    int rows = band.height() - 2;
+    int up = (s + shards - 1) % shards;
+    int down = (s + 1) % shards;
+
+    if (send_row(region, 2 * s, n, band.row(1), band.words())
+            || send_row(region, 2 * s + 1, n, band.row(rows), band.words())
+            || receive_row(region, 2 * up + 1, n, band, 0)
+            || receive_row(region, 2 * down, n, band, rows + 1))
+        return (EXIT_FAILURE);
+
+    return (EXIT_SUCCESS);
+}
+
+/*
+ * everything worker s does once forked: seeds its band and the rows
+ * either side of it from the checkpoint and the pattern, steps it, and
+ * writes its rows to part and its records to records, if there is one
+ */
+static int
+run_shard(ShardRegion& region, ShardPlan const& plan, int s, int threads,
+        FILE *part, FILE *records)
+{
+    int first = band_start(s, plan.shards, plan.height);
+    int rows = band_start(s + 1, plan.shards, plan.height) - first;
+    Board band(plan.width, rows + 2);
+    BandSink sink(band, first - 1, plan.height);
+    uint64_t population = 0;
+
+    if (plan.resume && plan.resume->load_rows(band, first - 1))
+        return (EXIT_FAILURE);
+    if (plan.input && read_pattern(plan.input, sink))
+        return (EXIT_FAILURE);
+    band.set_rule(plan.rule);
+    band.set_generation(plan.generation);
+    band.set_pool(std::make_shared<ThreadPool>(threads));
+
+    for (uint64_t n = 0; n < plan.generations; n++) {
+
+        band.step();
+        if (n + 1 < plan.generations
+                && exchange_rows(region, band, s, plan.shards, n))
+            return (EXIT_FAILURE);
+    }
+
+    for (int y = 1; y <= rows; y++) {
+
+        uint64_t const *row = band.row(y);
+
+        for (int i = 0; i < band.words(); i++)
+            population += std::popcount((i == band.words() - 1)
+                    ? row[i] & band.tail_mask() : row[i]);
+    }
+    region.population(s) = population;
+
+    if (!strcmp(plan.format, "rle") ? write_rle_rows(part, band, 1, rows + 1)
+            : write_plaintext_rows(part, band, 1, rows + 1))
+        return (EXIT_FAILURE);
+    if (records && write_checkpoint_records(records, band, 1, rows,
+                region.present() + static_cast<size_t>(first / B_TILE_ROWS)
+                * band.words(), &region.record_words(s)))
+        return (EXIT_FAILURE);
+
+    /* the worker leaves through _exit, which flushes nothing */
+    if (fflush(part) || (records && fflush(records)))
+        return (EXIT_FAILURE);
+
+    return (EXIT_SUCCESS);
+}
+
+/*
+ * steps the board plan describes on by plan.generations across
+ * plan.shards worker processes, which write it out to temporary files
+ * that write() and write_checkpoint() then put together
+ */
+int
+ShardRun::run(ShardPlan const& plan)
+{
+    ShardRegion region;
+    int tiles_y = (plan.height + B_TILE_ROWS - 1) / B_TILE_ROWS;
+    size_t tiles = static_cast<size_t>((plan.width + 63) / 64) * tiles_y;
+    int threads = plan.threads;
+    std::vector<pid_t> workers;
+    int status;
+    int rc = EXIT_SUCCESS;
+
+    if (plan.shards < 1 || plan.shards > SH_MAX_SHARDS || plan.shards > tiles_y) {
+
+        fprintf(stderr, "[ERROR] :: %s :: cannot split %d rows into %d "
+                "shards of whole tiles\n", __func__, plan.height, plan.shards);
+        return (EXIT_FAILURE);
+    }
+
+    this->sr_plan = plan;
+    for (int s = 0; s < plan.shards; s++) {
+
+        FILE *part = tmpfile();
+        FILE *records = (plan.checkpoint) ? tmpfile() : nullptr;
+
+        if (part)
+            this->sr_parts.push_back(part);
+        if (records)
+            this->sr_records.push_back(records);
+        if (!part || (plan.checkpoint && !records)) {
+
+            fprintf(stderr, "[ERROR] :: %s :: cannot open a temporary file\n",
+                    __func__);
+            return (EXIT_FAILURE);
+        }
+    }
+
+    if (region.map((plan.width + 63) / 64, plan.shards, tiles))
+        return (EXIT_FAILURE);
+
+    if (!threads)
+        threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency())
+                / plan.shards);
+
+    for (int s = 0; s < plan.shards; s++) {
+
+        pid_t pid = fork();
+
+        /* workers leave through _exit, so nothing the parent buffered is written twice */
+        if (!pid) {
+
+            if ((rc = run_shard(region, plan, s, threads, this->sr_parts[s],
+                            (plan.checkpoint) ? this->sr_records[s] : nullptr)))
+                region.failed().store(1, std::memory_order_relaxed);
+            _exit(rc);
+        }
+        if (pid < 0) {
+
+            fprintf(stderr, "[ERROR] :: %s :: cannot start shard %d\n",
+                    __func__, s);
+            region.failed().store(1, std::memory_order_relaxed);
+            rc = EXIT_FAILURE;
+            break;
+        }
+        workers.push_back(pid);
+    }
+
+    /* a worker that dies leaves its neighbours waiting, so it stops them all */
+    for (size_t done = 0; done < workers.size();) {
+
+        if (waitpid(-1, &status, 0) < 0) {
+
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+
+            region.failed().store(1, std::memory_order_relaxed);
+            rc = EXIT_FAILURE;
+        }
+        done++;
+    }
+
+    if (rc) {
+
+        fprintf(stderr, "[ERROR] :: %s :: a shard failed\n", __func__);
+        return (EXIT_FAILURE);
+    }
+
+    for (int s = 0; s < plan.shards; s++) {
+
+        this->sr_population += region.population(s);
+        this->sr_words += region.record_words(s);
+    }
+    this->sr_present.assign(region.present(), region.present() + tiles);
+    return (EXIT_SUCCESS);
+}
+
+#endif
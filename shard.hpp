@@ -0,0 +1,80 @@
+/**
+ * SHARD:
+ *  This file contains all prototypes and utilities needed to run a dense
+ *  board split across several worker processes
+ *
+ *  The board is cut into bands of whole tiles' rows, one per worker. A
+ *  worker keeps its band on a board of its own two rows taller, whose
+ *  first and last rows are ghosts of the rows just above and below the
+ *  band. Every generation it hands its own first and last rows to the
+ *  bands above and below through a ring of SH_RING_SLOTS rows in shared
+ *  memory, takes theirs into its ghost rows, and steps. Rows of the band
+ *  wrap around the torus on their own, so only rows cross between workers,
+ *  and the ghost rows' own next generation, which is wrong, is never read
+ *  before it is replaced. The result is the same, bit for bit, as stepping
+ *  the whole board in one process.
+ *
+ *  No process ever holds the whole board. Each worker seeds its band
+ *  itself, from its rows of the mapped checkpoint and from the runs of the
+ *  pattern file that land on it, and at the end writes the band's rows and
+ *  checkpoint records to files of its own. The coordinator only starts
+ *  the workers, stops them all if any one fails, and puts those files
+ *  together. A worker needs about twice its band, as a board in one
+ *  process needs twice the board; only rows and counts are shared.
+ *
+ *  file: shard.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+#include "rule.hpp"
+#include "checkpoint.hpp"
+
+#define SH_MAX_SHARDS 1024
+#define SH_RING_SLOTS 4         /* rows a worker may send ahead of its neighbour */
+#define SH_SPINS 1024           /* polls of a ring before yielding the core */
+
+/* the board a sharded run starts from, and what it writes at the end */
+struct ShardPlan {
+    int width;
+    int height;
+    Rule rule;
+    uint64_t generation;        /* of the board the run starts from */
+    uint64_t generations;       /* to step */
+    Checkpoint const *resume;   /* seeds the bands when not nullptr */
+    char const *input;          /* pattern put onto the bands, or nullptr */
+    char const *format;         /* "rle" or "cells" */
+    bool checkpoint;            /* whether the bands write checkpoint records */
+    int shards;
+    int threads;                /* per worker, 0 to share the cores out */
+};
+
+class ShardRun
+{
+    private:
+        ShardPlan sr_plan;
+        std::vector<FILE *> sr_parts;       /* each band's rows, in sr_plan.format */
+        std::vector<FILE *> sr_records;     /* each band's checkpoint records */
+        std::vector<uint8_t> sr_present;    /* a byte per tile with a record */
+        uint64_t sr_words;                  /* in all the records */
+        uint64_t sr_population;
+
+    public:
+        ShardRun(void);
+        ~ShardRun(void);
+
+        ShardRun(ShardRun const&) = delete;
+        ShardRun& operator=(ShardRun const&) = delete;
+
+        int run(ShardPlan const&);
+        int write(FILE *, char const * = nullptr) const;
+        int write_checkpoint(char const *) const;
+
+        [[ nodiscard ]] uint64_t population(void) const { return this->sr_population; }
+};
@@ -0,0 +1,261 @@
+/**
+ * SPARSE:
+ *  This file contains the unbounded sparse universe engine for Conway's
+ *  Game of Life
+ *
+ *  Each step first creates empty chunks wherever a live chunk has cells on
+ *  the shared border, then advances every chunk with the same bit-sliced
+ *  kernel the dense Board uses, and finally frees the chunks that came out
+ *  empty.
+ *
+ *  file: sparse.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+#include "rule.hpp"
+#include "sparse.hpp"
+#include "kernel.hpp"
+
+static inline int32_t
+chunk_of(int64_t v)
+{
+    /* arithmetic shift floors, so negative coordinates land correctly */
+    return static_cast<int32_t>(v >> 6);
+}
+
+SparseUniverse::SparseUniverse(void)
+{
+    this->s_generation = 0;
+    this->set_rule(R_CONWAY);
+}
+
+/* the step_chunk for the named_rules entry named, or the run-time one if -1 */
+template <size_t... I>
+SparseUniverse::chunk_kernel
+SparseUniverse::kernel_for(int named, std::index_sequence<I...>)
+{
+    static constexpr chunk_kernel kernels[] = {
+        &SparseUniverse::step_chunk<named_rules[I].rule.bits()>...,
+        &SparseUniverse::step_chunk<K_RUNTIME>,
+    };
+
+    return (named < 0) ? kernels[R_NAMED_RULES] : kernels[named];
+}
+
+/* picks the kernel compiled for the rule once, rather than every chunk */
+void
+SparseUniverse::set_rule(Rule const& rule)
+{
+    this->s_rule = rule;
+    this->s_kernel = kernel_for(named_rule_index(rule),
+            std::make_index_sequence<R_NAMED_RULES>());
+}
+
+SparseUniverse::Chunk const *
+SparseUniverse::find(int32_t cx, int32_t cy) const
+{
+    auto it = this->s_chunks.find(key(cx, cy));
+
+    return (it == this->s_chunks.end()) ? nullptr : &it->second;
+}
+
+void
+SparseUniverse::set_cell(int64_t x, int64_t y, bool alive)
+{
+    uint64_t k = key(chunk_of(x), chunk_of(y));
+    uint64_t bit = uint64_t{1} << (x & (S_CHUNK_SIZE - 1));
+    auto it = this->s_chunks.find(k);
+
+    if (alive) {
+
+        if (it == this->s_chunks.end())
+            it = this->s_chunks.emplace(k, Chunk{}).first;
+        it->second.cells[y & (S_CHUNK_SIZE - 1)] |= bit;
+    } else if (it != this->s_chunks.end()) {
+
+        it->second.cells[y & (S_CHUNK_SIZE - 1)] &= ~bit;
+    }
+}
+
+/* brings count cells to life running east from (x, y), a word at a time */
+void
+SparseUniverse::set_run(int64_t x, int64_t y, int64_t count)
+{
+    int32_t cy = chunk_of(y);
+
+    while (count > 0) {
+
+        int offset = static_cast<int>(x & (S_CHUNK_SIZE - 1));
+        int n = static_cast<int>(std::min<int64_t>(count, S_CHUNK_SIZE - offset));
+        uint64_t bits = (n == 64) ? ~uint64_t{0}
+            : ((uint64_t{1} << n) - 1) << offset;
+        uint64_t k = key(chunk_of(x), cy);
+        auto it = this->s_chunks.find(k);
+
+        if (it == this->s_chunks.end())
+            it = this->s_chunks.emplace(k, Chunk{}).first;
+        it->second.cells[y & (S_CHUNK_SIZE - 1)] |= bits;
+
+        x += n;
+        count -= n;
+    }
+}
+
+bool
+SparseUniverse::get_cell(int64_t x, int64_t y) const
+{
+    Chunk const *chunk = this->find(chunk_of(x), chunk_of(y));
+
+    if (!chunk)
+        return (false);
+
+    return (chunk->cells[y & (S_CHUNK_SIZE - 1)] >> (x & (S_CHUNK_SIZE - 1))) & 1;
+}
+
+void
+SparseUniverse::clear(void)
+{
+    this->s_chunks.clear();
+    this->s_generation = 0;
+}
+
+uint64_t
+SparseUniverse::population(void) const
+{
+    uint64_t population = 0;
+
+    for (auto const& [k, chunk] : this->s_chunks) {
+
+        for (uint64_t row : chunk.cells)
+            population += std::popcount(row);
+    }
+
+    return (population);
+}
+
+/* computes chunk.next from the chunk and its eight neighbours */
+template <uint32_t RULE>
+void
+SparseUniverse::step_chunk(uint64_t k, Chunk& chunk)
+{
+    static Chunk const nothing = {};
+    int32_t cx = key_x(k);
+    int32_t cy = key_y(k);
+    Chunk const *around[3][3];
+
+    for (int dy = -1; dy <= 1; dy++) {
+
+        for (int dx = -1; dx <= 1; dx++) {
+
+            Chunk const *c = (dx || dy) ? this->find(cx + dx, cy + dy) : &chunk;
+            around[dy + 1][dx + 1] = (c) ? c : &nothing;
+        }
+    }
+
+    /*
+     * rows -1 and 64 come from the chunks above and below; for every row
+     * the west and east words only contribute their border bit
+     */
+    uint64_t west[S_CHUNK_SIZE + 2];
+    uint64_t mid[S_CHUNK_SIZE + 2];
+    uint64_t east[S_CHUNK_SIZE + 2];
+
+    for (int r = 0; r < 3; r++) {
+
+        int from = (r == 0) ? S_CHUNK_SIZE - 1 : 0;
+        int to = (r == 0) ? 0 : (r == 2) ? S_CHUNK_SIZE + 1 : 1;
+        int count = (r == 1) ? S_CHUNK_SIZE : 1;
+
+        std::copy_n(around[r][0]->cells + from, count, west + to);
+        std::copy_n(around[r][1]->cells + from, count, mid + to);
+        std::copy_n(around[r][2]->cells + from, count, east + to);
+    }
+
+    for (int y = 1; y <= S_CHUNK_SIZE; y++) {
+
+        uint64_t n = mid[y - 1], c = mid[y], s = mid[y + 1];
+
+        life_kernel<RULE>(chunk.next[y - 1],
+                (n << 1) | (west[y - 1] >> 63), n, (n >> 1) | (east[y - 1] << 63),
+                (c << 1) | (west[y] >> 63), c, (c >> 1) | (east[y] << 63),
+                (s << 1) | (west[y + 1] >> 63), s, (s >> 1) | (east[y + 1] << 63),
+                this->s_rule.bits());
+    }
+}
+
+void
+SparseUniverse::step(void)
+{
+    /* chunks a live border could spill into, that do not exist yet */
+    this->s_spawn.clear();
+    for (auto const& [k, chunk] : this->s_chunks) {
+
+        uint64_t west = 0;
+        uint64_t east = 0;
+        uint64_t top = chunk.cells[0];
+        uint64_t bottom = chunk.cells[S_CHUNK_SIZE - 1];
+        int32_t cx = key_x(k);
+        int32_t cy = key_y(k);
+
+        for (uint64_t row : chunk.cells) {
+
+            west |= row & 1;
+            east |= row >> 63;
+        }
+
+        bool spill[3][3] = {
+            {(top & 1) != 0, top != 0, (top >> 63) != 0},
+            {west != 0, false, east != 0},
+            {(bottom & 1) != 0, bottom != 0, (bottom >> 63) != 0},
+        };
+
+        for (int dy = -1; dy <= 1; dy++) {
+
+            for (int dx = -1; dx <= 1; dx++) {
+
+                if (spill[dy + 1][dx + 1] && !this->find(cx + dx, cy + dy))
+                    this->s_spawn.push_back(key(cx + dx, cy + dy));
+            }
+        }
+    }
+
+    for (uint64_t k : this->s_spawn)
+        this->s_chunks.try_emplace(k, Chunk{});
+
+    /* every named rule has its own kernel, any other reads the masks as it goes */
+    chunk_kernel kernel = this->s_kernel;
+
+    for (auto& [k, chunk] : this->s_chunks)
+        (this->*kernel)(k, chunk);
+
+    for (auto it = this->s_chunks.begin(); it != this->s_chunks.end();) {
+
+        Chunk& chunk = it->second;
+        uint64_t any = 0;
+
+        std::copy_n(chunk.next, S_CHUNK_SIZE, chunk.cells);
+        for (uint64_t row : chunk.cells)
+            any |= row;
+
+        if (any)
+            ++it;
+        else
+            it = this->s_chunks.erase(it);
+    }
+
+    this->s_generation++;
+}
+
+void
+SparseUniverse::advance(uint64_t generations)
+{
+    while (generations--)
+        this->step();
+}
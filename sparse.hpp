@@ -0,0 +1,114 @@
+/**
+ * SPARSE:
+ *  This file contains all prototypes and utilities needed for the unbounded
+ *  sparse universe engine for Conway's Game of Life and the other
+ *  Life-like rules
+ *
+ *  Live cells are kept in 64x64 chunks, one bit per cell, held in a hash
+ *  map keyed by chunk coordinate. A chunk only exists while it has live
+ *  cells or is about to receive some from a neighbour, so memory and step
+ *  time follow the population rather than the pattern's bounding box.
+ *
+ *  file: sparse.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <bit>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <unordered_map>
+
+#include "rule.hpp"
+
+#define S_CHUNK_SIZE 64
+
+class SparseUniverse
+{
+    private:
+        struct Chunk {
+            uint64_t cells[S_CHUNK_SIZE];
+            uint64_t next[S_CHUNK_SIZE];
+        };
+
+        struct KeyHash {
+            size_t operator()(uint64_t key) const
+            {
+                key ^= key >> 33;
+                key *= 0xFF51AFD7ED558CCDull;
+                key ^= key >> 33;
+                return static_cast<size_t>(key);
+            }
+        };
+
+        using chunk_kernel = void (SparseUniverse::*)(uint64_t, Chunk&);
+
+        std::unordered_map<uint64_t, Chunk, KeyHash> s_chunks;
+        std::vector<uint64_t> s_spawn;
+        uint64_t s_generation;
+        Rule s_rule;
+        chunk_kernel s_kernel;          /* step_chunk compiled for s_rule */
+
+        [[ nodiscard ]] static uint64_t key(int32_t cx, int32_t cy)
+        {
+            return (uint64_t{static_cast<uint32_t>(cx)} << 32)
+                | static_cast<uint32_t>(cy);
+        }
+
+        [[ nodiscard ]] static int32_t key_x(uint64_t k)
+        {
+            return static_cast<int32_t>(static_cast<uint32_t>(k >> 32));
+        }
+
+        [[ nodiscard ]] static int32_t key_y(uint64_t k)
+        {
+            return static_cast<int32_t>(static_cast<uint32_t>(k));
+        }
+
+        [[ nodiscard ]] Chunk const *find(int32_t, int32_t) const;
+        template <uint32_t RULE> void step_chunk(uint64_t, Chunk&);
+        template <size_t... I>
+        [[ nodiscard ]] static chunk_kernel kernel_for(int, std::index_sequence<I...>);
+
+    public:
+        SparseUniverse(void);
+
+        void set_cell(int64_t, int64_t, bool);
+        void set_run(int64_t, int64_t, int64_t);
+        [[ nodiscard ]] bool get_cell(int64_t, int64_t) const;
+        void clear(void);
+        void step(void);
+        void advance(uint64_t);
+        void set_rule(Rule const&);
+        [[ nodiscard ]] Rule const& rule(void) const { return this->s_rule; }
+
+        [[ nodiscard ]] uint64_t generation(void) const { return this->s_generation; }
+        [[ nodiscard ]] uint64_t population(void) const;
+        [[ nodiscard ]] size_t chunk_count(void) const { return this->s_chunks.size(); }
+
+        /* calls fn(x, y) for every live cell */
+        template <typename F>
+        void for_each_alive(F&& fn) const
+        {
+            for (auto const& [k, chunk] : this->s_chunks) {
+
+                int64_t x0 = int64_t{key_x(k)} * S_CHUNK_SIZE;
+                int64_t y0 = int64_t{key_y(k)} * S_CHUNK_SIZE;
+
+                for (int y = 0; y < S_CHUNK_SIZE; y++) {
+
+                    uint64_t row = chunk.cells[y];
+
+                    while (row) {
+
+                        fn(x0 + std::countr_zero(row), y0 + y);
+                        row &= row - 1;
+                    }
+                }
+            }
+        }
+};
@@ -0,0 +1,69 @@
+/**
+ * TEST_CYCLE:
+ *  This file contains the regression test for skipping through cycles
+ *  across more than one call
+ *
+ *  A glider on a 64x64 torus comes back to the same cells every 256
+ *  generations. The first call has to step until it notices; every call
+ *  after it, until the board is edited, should only step what is left
+ *  over after whole periods and never find the cycle again.
+ *
+ *  file: test_cycle.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+
+#include "board.hpp"
+#include "cycle.hpp"
+
+#define T_GENERATIONS 1000      /* per call, more than one period */
+#define T_CALLS 4
+
+int
+main(void)
+{
+    Board board(64, 64);
+    CycleDetector cycles;
+    uint64_t steps;
+    int rc = EXIT_SUCCESS;
+
+    board.set(1, 0, 1);
+    board.set(2, 1, 1);
+    board.set(0, 2, 1);
+    board.set(1, 2, 1);
+    board.set(2, 2, 1);
+
+    for (int call = 0; call < T_CALLS; call++) {
+
+        steps = 0;
+        advance_through_cycles(board, cycles, T_GENERATIONS, false,
+                [&steps]() { steps++; });
+
+        printf("call %d: generation %llu, period %llu, %llu steps\n", call,
+                static_cast<unsigned long long>(board.generation()),
+                static_cast<unsigned long long>(cycles.period()),
+                static_cast<unsigned long long>(steps));
+
+        if (board.generation() != static_cast<uint64_t>(call + 1) * T_GENERATIONS
+                || cycles.period() != 256) {
+
+            fprintf(stderr, "[ERROR] :: %s :: call %d lost the cycle\n",
+                    __func__, call);
+            rc = EXIT_FAILURE;
+        }
+        /* a skip counts as one call of stepped(), on top of the remainder */
+        if (call && steps > cycles.period()) {
+
+            fprintf(stderr, "[ERROR] :: %s :: call %d stepped %llu "
+                    "generations, more than a period\n", __func__, call,
+                    static_cast<unsigned long long>(steps));
+            rc = EXIT_FAILURE;
+        }
+    }
+
+    return (rc);
+}
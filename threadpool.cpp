@@ -0,0 +1,184 @@
+/**
+ * THREADPOOL:
+ *  This file contains the persistent work-stealing thread pool
+ *
+ *  file: threadpool.cpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+
+#include "threadpool.hpp"
+
+static inline uint64_t
+pack(uint32_t begin, uint32_t end)
+{
+    return (uint64_t{begin} << 32) | end;
+}
+
+/* threads <= 0 asks for one thread per hardware thread */
+ThreadPool::ThreadPool(int threads)
+{
+    if (threads <= 0)
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+
+    this->t_size = (threads > 0) ? threads : 1;
+    this->t_queues = std::make_unique<Queue[]>(this->t_size);
+    this->t_epoch = 0;
+    this->t_busy = 0;
+    this->t_stopping = false;
+    this->t_job = nullptr;
+
+    for (int i = 0; i < this->t_size; i++)
+        this->t_queues[i].range.store(0, std::memory_order_relaxed);
+
+    for (int i = 1; i < this->t_size; i++)
+        this->t_workers.emplace_back(&ThreadPool::worker, this, i);
+}
+
+ThreadPool::~ThreadPool(void)
+{
+    {
+        std::lock_guard<std::mutex> guard(this->t_lock);
+        this->t_stopping = true;
+    }
+    this->t_wake.notify_all();
+
+    for (auto& thread : this->t_workers)
+        thread.join();
+}
+
+/* takes the next task from the front of this thread's own range */
+bool
+ThreadPool::take(int self, int *task)
+{
+    std::atomic<uint64_t>& range = this->t_queues[self].range;
+    uint64_t r = range.load(std::memory_order_relaxed);
+
+    for (;;) {
+
+        uint32_t begin = static_cast<uint32_t>(r >> 32);
+        uint32_t end = static_cast<uint32_t>(r);
+
+        if (begin >= end)
+            return (false);
+
+        if (range.compare_exchange_weak(r, pack(begin + 1, end),
+                    std::memory_order_acq_rel)) {
+
+            *task = static_cast<int>(begin);
+            return (true);
+        }
+    }
+}
+
+/* takes a task from the back of some other thread's range */
+bool
+ThreadPool::steal(int self, int *task)
+{
+    for (int i = 1; i < this->t_size; i++) {
+
+        std::atomic<uint64_t>& range =
+            this->t_queues[(self + i) % this->t_size].range;
+        uint64_t r = range.load(std::memory_order_relaxed);
+
+        for (;;) {
+
+            uint32_t begin = static_cast<uint32_t>(r >> 32);
+            uint32_t end = static_cast<uint32_t>(r);
+
+            if (begin >= end)
+                break;
+
+            if (range.compare_exchange_weak(r, pack(begin, end - 1),
+                        std::memory_order_acq_rel)) {
+
+                *task = static_cast<int>(end - 1);
+                return (true);
+            }
+        }
+    }
+
+    return (false);
+}
+
+void
+ThreadPool::drain(int self)
+{
+    int task;
+
+    while (this->take(self, &task) || this->steal(self, &task))
+        (*this->t_job)(task);
+}
+
+void
+ThreadPool::worker(int self)
+{
+    uint64_t seen = 0;
+
+    for (;;) {
+
+        {
+            std::unique_lock<std::mutex> guard(this->t_lock);
+            this->t_wake.wait(guard, [&] {
+                return (this->t_stopping || this->t_epoch != seen);
+            });
+
+            if (this->t_stopping)
+                return;
+            seen = this->t_epoch;
+        }
+
+        this->drain(self);
+
+        {
+            std::lock_guard<std::mutex> guard(this->t_lock);
+            if (--this->t_busy == 0)
+                this->t_done.notify_one();
+        }
+    }
+}
+
+/*
+ * runs fn(0) .. fn(count - 1) across the pool and returns once every call
+ * has finished
+ */
+void
+ThreadPool::parallel_for(int count, std::function<void(int)> const& fn)
+{
+    if (count <= 1 || this->t_size == 1) {
+
+        for (int i = 0; i < count; i++)
+            fn(i);
+        return;
+    }
+
+    for (int i = 0; i < this->t_size; i++) {
+
+        uint32_t begin = static_cast<uint32_t>(
+                static_cast<int64_t>(count) * i / this->t_size);
+        uint32_t end = static_cast<uint32_t>(
+                static_cast<int64_t>(count) * (i + 1) / this->t_size);
+
+        this->t_queues[i].range.store(pack(begin, end),
+                std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(this->t_lock);
+        this->t_job = &fn;
+        this->t_busy = this->t_size - 1;
+        this->t_epoch++;
+    }
+    this->t_wake.notify_all();
+
+    this->drain(0);
+
+    std::unique_lock<std::mutex> guard(this->t_lock);
+    this->t_done.wait(guard, [&] { return (this->t_busy == 0); });
+    this->t_job = nullptr;
+}
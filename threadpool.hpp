@@ -0,0 +1,63 @@
+/**
+ * THREADPOOL:
+ *  This file contains all prototypes and utilities needed for the
+ *  persistent worker pool used to step large boards in parallel
+ *
+ *  Work handed to parallel_for is split into one contiguous range of task
+ *  indices per thread. Each thread takes tasks from the front of its own
+ *  range and, once that runs dry, steals from the back of the others, so
+ *  uneven tasks still keep every core busy. The calling thread takes part
+ *  as worker 0.
+ *
+ *  file: threadpool.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+class ThreadPool
+{
+    private:
+        /* packed [begin, end) of the tasks a thread still owns */
+        struct alignas(64) Queue {
+            std::atomic<uint64_t> range;
+        };
+
+        std::vector<std::thread> t_workers;
+        std::unique_ptr<Queue[]> t_queues;
+        int t_size;
+
+        std::mutex t_lock;
+        std::condition_variable t_wake;
+        std::condition_variable t_done;
+        uint64_t t_epoch;
+        int t_busy;
+        bool t_stopping;
+        std::function<void(int)> const *t_job;
+
+        void worker(int);
+        void drain(int);
+        [[ nodiscard ]] bool take(int, int *);
+        [[ nodiscard ]] bool steal(int, int *);
+
+    public:
+        explicit ThreadPool(int threads = 0);
+        ~ThreadPool(void);
+
+        ThreadPool(ThreadPool const&) = delete;
+        ThreadPool& operator=(ThreadPool const&) = delete;
+
+        [[ nodiscard ]] int size(void) const { return this->t_size; }
+
+        void parallel_for(int, std::function<void(int)> const&);
+};
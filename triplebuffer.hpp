@@ -0,0 +1,71 @@
+/**
+ * TRIPLEBUFFER:
+ *  This file contains the lock-free triple buffer used to hand completed
+ *  generations from the simulation thread to the render thread
+ *
+ *  The writer fills the back slot and publishes it by swapping it with the
+ *  middle slot; the reader picks up the middle slot by swapping it with
+ *  the front one. Neither side ever waits for the other, and the reader
+ *  always sees the most recently published value in full.
+ *
+ *  file: triplebuffer.hpp
+ *  author: Nathan Corcoran
+ *  year: 2022
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+template <typename T>
+class TripleBuffer
+{
+    private:
+        /* set on the middle index while it holds a slot the reader hasn't taken */
+        static constexpr uint8_t TB_FRESH = 0x4;
+
+        T tb_slots[3];
+        alignas(64) std::atomic<uint8_t> tb_middle;
+        alignas(64) uint8_t tb_back;        /* only touched by the writer */
+        alignas(64) uint8_t tb_front;       /* only touched by the reader */
+
+    public:
+        TripleBuffer(void) : tb_middle(1), tb_back(0), tb_front(2) {}
+
+        TripleBuffer(TripleBuffer const&) = delete;
+        TripleBuffer& operator=(TripleBuffer const&) = delete;
+
+        /* writer: the slot to fill before the next publish() */
+        [[ nodiscard ]] T& back(void) { return this->tb_slots[this->tb_back]; }
+
+        void publish(void)
+        {
+            uint8_t old = this->tb_middle.exchange(this->tb_back | TB_FRESH,
+                    std::memory_order_acq_rel);
+            this->tb_back = old & 0x3;
+        }
+
+        /* writer: true once the last published slot has been picked up */
+        [[ nodiscard ]] bool consumed(void) const
+        {
+            return !(this->tb_middle.load(std::memory_order_acquire) & TB_FRESH);
+        }
+
+        /* reader: takes the newest published slot, if there is one */
+        bool update(void)
+        {
+            if (this->consumed())
+                return (false);
+
+            uint8_t old = this->tb_middle.exchange(this->tb_front,
+                    std::memory_order_acq_rel);
+            this->tb_front = old & 0x3;
+            return (true);
+        }
+
+        [[ nodiscard ]] T const& front(void) const
+        {
+            return this->tb_slots[this->tb_front];
+        }
+};